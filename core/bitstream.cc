@@ -0,0 +1,188 @@
+#include "core/pch.hh"
+
+#include "core/bitstream.hh"
+
+static std::uint64_t quantize_steps(unsigned int bits) noexcept
+{
+    assert(bits >= 1 && bits <= 32);
+
+    return (UINT64_C(1) << bits) - UINT64_C(1);
+}
+
+std::size_t BitWriter::size(void) const
+{
+    return m_vector.size();
+}
+
+const std::byte* BitWriter::data(void) const
+{
+    return m_vector.data();
+}
+
+void BitWriter::reset(void)
+{
+    m_vector.clear();
+    m_scratch = 0;
+    m_bits = 0;
+}
+
+void BitWriter::flush(void)
+{
+    while(m_bits > 0) {
+        m_vector.push_back(static_cast<std::byte>(m_scratch));
+        m_scratch >>= 8;
+        m_bits -= std::min(m_bits, 8U);
+    }
+
+    m_scratch = 0;
+}
+
+void BitWriter::write_bits_64(std::uint64_t value, unsigned int count)
+{
+    assert(count <= 64);
+
+    write_bits(static_cast<std::uint32_t>(value), std::min(count, 32U));
+
+    if(count > 32) {
+        write_bits(static_cast<std::uint32_t>(value >> 32), count - 32);
+    }
+}
+
+void BitWriter::write_bool(bool value)
+{
+    write_bits(value ? 1U : 0U, 1);
+}
+
+void BitWriter::write_varint(std::uint64_t value)
+{
+    while(value >= 0x80) {
+        write_bits(static_cast<std::uint32_t>((value & 0x7F) | 0x80), 8);
+        value >>= 7;
+    }
+
+    write_bits(static_cast<std::uint32_t>(value), 8);
+}
+
+void BitWriter::write_zigzag(std::int64_t value)
+{
+    write_varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+void BitWriter::write_float(float value, float min, float max, unsigned int bits)
+{
+    assert(max > min);
+
+    auto steps = quantize_steps(bits);
+
+    // NaN compares false against everything and
+    // thus ends up being written as the lower bound
+    auto normalized = (static_cast<double>(value) - min) / (static_cast<double>(max) - min);
+    normalized = (normalized > 0.0) ? std::min(normalized, 1.0) : 0.0;
+
+    write_bits(static_cast<std::uint32_t>(std::floor(normalized * static_cast<double>(steps) + 0.5)), bits);
+}
+
+BitReader::BitReader(const void* data, std::size_t size)
+{
+    reset(data, size);
+}
+
+void BitReader::reset(const void* data, std::size_t size)
+{
+    assert(data || size == 0);
+
+    m_data = reinterpret_cast<const std::byte*>(data);
+    m_size = size;
+    m_position = 0;
+    m_scratch = 0;
+    m_bits = 0;
+    m_overrun = false;
+}
+
+void BitReader::align(void)
+{
+    auto padding = m_bits % 8;
+    m_scratch >>= padding;
+    m_bits -= padding;
+}
+
+std::uint64_t BitReader::read_bits_64(unsigned int count)
+{
+    assert(count <= 64);
+
+    auto result = static_cast<std::uint64_t>(read_bits(std::min(count, 32U)));
+
+    if(count > 32) {
+        result |= static_cast<std::uint64_t>(read_bits(count - 32)) << 32;
+    }
+
+    return result;
+}
+
+bool BitReader::read_bool(void)
+{
+    return read_bits(1) != 0U;
+}
+
+std::uint64_t BitReader::read_varint(void)
+{
+    auto result = UINT64_C(0);
+
+    for(unsigned int shift = 0; shift < 64; shift += 7) {
+        auto value = read_bits(8);
+        result |= static_cast<std::uint64_t>(value & 0x7F) << shift;
+
+        if(!(value & 0x80)) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+std::int64_t BitReader::read_zigzag(void)
+{
+    auto value = read_varint();
+    return static_cast<std::int64_t>((value >> 1) ^ (UINT64_C(0) - (value & 1)));
+}
+
+float BitReader::read_float(float min, float max, unsigned int bits)
+{
+    assert(max > min);
+
+    auto steps = quantize_steps(bits);
+    auto normalized = static_cast<double>(read_bits(bits)) / static_cast<double>(steps);
+
+    return static_cast<float>(min + normalized * (static_cast<double>(max) - min));
+}
+
+void BitReader::refill(void)
+{
+    assert(m_bits < 56);
+
+    if(m_position + 8 <= m_size) {
+        // Load eight bytes at once and keep as many whole
+        // bytes as fit; bits of the byte that doesn't fit end
+        // up above m_bits and get loaded again on the next refill
+        auto word = UINT64_C(0);
+        word |= static_cast<std::uint64_t>(m_data[m_position + 0]) << 0;
+        word |= static_cast<std::uint64_t>(m_data[m_position + 1]) << 8;
+        word |= static_cast<std::uint64_t>(m_data[m_position + 2]) << 16;
+        word |= static_cast<std::uint64_t>(m_data[m_position + 3]) << 24;
+        word |= static_cast<std::uint64_t>(m_data[m_position + 4]) << 32;
+        word |= static_cast<std::uint64_t>(m_data[m_position + 5]) << 40;
+        word |= static_cast<std::uint64_t>(m_data[m_position + 6]) << 48;
+        word |= static_cast<std::uint64_t>(m_data[m_position + 7]) << 56;
+
+        m_scratch |= word << m_bits;
+        m_position += (63 - m_bits) >> 3;
+        m_bits |= 56;
+        return;
+    }
+
+    while(m_bits <= 56 && m_position < m_size) {
+        m_scratch |= static_cast<std::uint64_t>(m_data[m_position]) << m_bits;
+        m_position += 1;
+        m_bits += 8;
+    }
+}
@@ -0,0 +1,161 @@
+#ifndef CORE_BITSTREAM_HH
+#define CORE_BITSTREAM_HH
+#pragma once
+
+/// Packs values into a stream of bits; bits are laid out
+/// least significant first, so bit N of the stream is bit N % 8
+/// of byte N / 8 regardless of the host byte order
+class BitWriter final {
+public:
+    BitWriter(void) = default;
+    virtual ~BitWriter(void) = default;
+
+    /// Amount of bytes written; includes the partially written
+    /// byte only after the stream has been flushed
+    std::size_t size(void) const;
+    const std::byte* data(void) const;
+    constexpr std::size_t bit_size(void) const;
+
+    void reset(void);
+
+    /// Write out pending bits padding the last byte with zeroes;
+    /// the writer can continue writing afterwards from the next byte
+    void flush(void);
+
+    /// Write the lowest bits of a value
+    /// @param value Value to write, bits above count are ignored
+    /// @param count Amount of bits to write, at most 32
+    inline void write_bits(std::uint32_t value, unsigned int count);
+
+    void write_bits_64(std::uint64_t value, unsigned int count);
+    void write_bool(bool value);
+
+    /// Write an unsigned integer as LEB128; small
+    /// values take as little as a single byte
+    /// @param value Value to write
+    void write_varint(std::uint64_t value);
+
+    /// Write a signed integer as a zigzag-encoded LEB128 varint;
+    /// small negative values take as little space as small positive ones
+    /// @param value Value to write
+    void write_zigzag(std::int64_t value);
+
+    /// Write a float quantized over a fixed range
+    /// @param value Value to write, clamped to [min, max]
+    /// @param min Lower bound of the range
+    /// @param max Upper bound of the range
+    /// @param bits Amount of bits the value occupies, 1 to 32
+    void write_float(float value, float min, float max, unsigned int bits);
+
+private:
+    std::vector<std::byte> m_vector;
+    std::uint64_t m_scratch { 0 };
+    unsigned int m_bits { 0 };
+};
+
+/// Unpacks values written by BitWriter; the reader borrows the
+/// memory it decodes, which must stay valid while it's in use; reading
+/// past the end yields zero bits and marks the reader as overrun
+class BitReader final {
+public:
+    BitReader(void) = default;
+    explicit BitReader(const void* data, std::size_t size);
+    virtual ~BitReader(void) = default;
+
+    void reset(const void* data, std::size_t size);
+
+    constexpr bool is_ended(void) const;
+    constexpr bool is_overrun(void) const;
+
+    /// Skip pending bits up to the next byte boundary;
+    /// this mirrors BitWriter::flush on the writing side
+    void align(void);
+
+    /// Read a value of the given amount of bits
+    /// @param count Amount of bits to read, at most 32
+    /// @return The value or zero bits past the end of data
+    inline std::uint32_t read_bits(unsigned int count);
+
+    std::uint64_t read_bits_64(unsigned int count);
+    bool read_bool(void);
+
+    std::uint64_t read_varint(void);
+    std::int64_t read_zigzag(void);
+
+    /// Read a float quantized by BitWriter::write_float; the
+    /// range and bit count must match the ones used for writing
+    /// @param min Lower bound of the range
+    /// @param max Upper bound of the range
+    /// @param bits Amount of bits the value occupies, 1 to 32
+    /// @return The dequantized value
+    float read_float(float min, float max, unsigned int bits);
+
+private:
+    void refill(void);
+
+private:
+    const std::byte* m_data { nullptr };
+    std::size_t m_size { 0 };
+    std::size_t m_position { 0 };
+    std::uint64_t m_scratch { 0 };
+    unsigned int m_bits { 0 };
+    bool m_overrun { false };
+};
+
+constexpr std::size_t BitWriter::bit_size(void) const
+{
+    return 8 * m_vector.size() + m_bits;
+}
+
+inline void BitWriter::write_bits(std::uint32_t value, unsigned int count)
+{
+    assert(count <= 32);
+
+    auto mask = (UINT64_C(1) << count) - UINT64_C(1);
+    m_scratch |= (static_cast<std::uint64_t>(value) & mask) << m_bits;
+    m_bits += count;
+
+    if(m_bits >= 32) {
+        m_vector.push_back(static_cast<std::byte>(m_scratch >> 0));
+        m_vector.push_back(static_cast<std::byte>(m_scratch >> 8));
+        m_vector.push_back(static_cast<std::byte>(m_scratch >> 16));
+        m_vector.push_back(static_cast<std::byte>(m_scratch >> 24));
+        m_scratch >>= 32;
+        m_bits -= 32;
+    }
+}
+
+constexpr bool BitReader::is_ended(void) const
+{
+    return m_bits == 0 && m_position >= m_size;
+}
+
+constexpr bool BitReader::is_overrun(void) const
+{
+    return m_overrun;
+}
+
+inline std::uint32_t BitReader::read_bits(unsigned int count)
+{
+    assert(count <= 32);
+
+    if(count > m_bits) {
+        refill();
+
+        if(count > m_bits) {
+            auto result = static_cast<std::uint32_t>(m_scratch);
+            m_overrun = true;
+            m_scratch = 0;
+            m_bits = 0;
+            return result;
+        }
+    }
+
+    auto mask = (UINT64_C(1) << count) - UINT64_C(1);
+    auto result = static_cast<std::uint32_t>(m_scratch & mask);
+    m_scratch >>= count;
+    m_bits -= count;
+    return result;
+}
+
+#endif
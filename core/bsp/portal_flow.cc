@@ -0,0 +1,230 @@
+#include "core/pch.hh"
+
+#include "core/bsp/portal_flow.hh"
+
+#include "core/bsp/pvis.hh"
+#include "core/exceptions.hh"
+#include "core/math/frustum.hh"
+#include "core/utils/bitset.hh"
+
+constexpr static std::size_t FLOW_MAX_DEPTH = 64;     ///< Deeper chains of portals are cut off
+constexpr static float FLOW_EPSILON = 1.0f / 1024.0f; ///< Portals closer than this to the eye don't narrow the view
+
+static void clip_polygon(const std::vector<Eigen::Vector3f>& polygon, const Eigen::Hyperplane<float, 3>& plane,
+    std::vector<Eigen::Vector3f>& out_polygon)
+{
+    out_polygon.clear();
+
+    for(std::size_t i = 0; i < polygon.size(); ++i) {
+        const auto& a = polygon[i];
+        const auto& b = polygon[(i + 1) % polygon.size()];
+
+        auto distance_a = plane.signedDistance(a);
+        auto distance_b = plane.signedDistance(b);
+
+        if(distance_a >= 0.0f) {
+            out_polygon.push_back(a);
+        }
+
+        if((distance_a >= 0.0f) != (distance_b >= 0.0f)) {
+            auto factor = distance_a / (distance_a - distance_b);
+            out_polygon.push_back(a + factor * (b - a));
+        }
+    }
+}
+
+void bsp::PortalFlow::set_pvis(const bsp::PVis& pvis)
+{
+    const auto& portals = pvis.portals();
+    const auto& vertices = pvis.vertices();
+
+    std::size_t leaf_count = 0;
+    std::vector<Eigen::Hyperplane<float, 3>> portal_planes;
+    portal_planes.reserve(portals.size());
+
+    for(std::size_t i = 0; i < portals.size(); ++i) {
+        const auto& portal = portals[i];
+
+        auto vertex_end = static_cast<std::size_t>(portal.portal_vertex_offset) + portal.portal_vertex_count;
+        qf::throw_if_fmt<std::runtime_error>(portal.portal_vertex_count && vertex_end > vertices.size(),
+            "portal {} vertices are out of bounds", i);
+
+        // Newell's method gives a sensible normal
+        // even for slightly non-planar polygons
+        Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+        Eigen::Vector3f center = Eigen::Vector3f::Zero();
+
+        for(std::uint32_t j = 0; j < portal.portal_vertex_count; ++j) {
+            const auto& a = vertices[portal.portal_vertex_offset + j];
+            const auto& b = vertices[portal.portal_vertex_offset + (j + 1) % portal.portal_vertex_count];
+            normal.x() += (a.y() - b.y()) * (a.z() + b.z());
+            normal.y() += (a.z() - b.z()) * (a.x() + b.x());
+            normal.z() += (a.x() - b.x()) * (a.y() + b.y());
+            center += a;
+        }
+
+        if(portal.portal_vertex_count) {
+            center /= static_cast<float>(portal.portal_vertex_count);
+        }
+
+        if(normal.squaredNorm() > 0.0f) {
+            normal.normalize();
+        }
+
+        portal_planes.emplace_back(normal, center);
+
+        for(auto leaf : { portal.front_leaf_index, portal.back_leaf_index }) {
+            if(leaf != UINT32_MAX) {
+                leaf_count = std::max<std::size_t>(leaf_count, static_cast<std::size_t>(leaf) + 1);
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> leaf_portal_offsets(leaf_count + 1, 0);
+
+    for(const auto& portal : portals) {
+        for(auto leaf : { portal.front_leaf_index, portal.back_leaf_index }) {
+            if(leaf != UINT32_MAX) {
+                leaf_portal_offsets[leaf + 1] += 1;
+            }
+        }
+    }
+
+    for(std::size_t i = 0; i < leaf_count; ++i) {
+        leaf_portal_offsets[i + 1] += leaf_portal_offsets[i];
+    }
+
+    std::vector<std::uint32_t> leaf_portal_list(leaf_portal_offsets.back());
+    std::vector<std::uint32_t> cursors(leaf_portal_offsets.begin(), leaf_portal_offsets.end() - 1);
+
+    for(std::size_t i = 0; i < portals.size(); ++i) {
+        for(auto leaf : { portals[i].front_leaf_index, portals[i].back_leaf_index }) {
+            if(leaf != UINT32_MAX) {
+                leaf_portal_list[cursors[leaf]++] = static_cast<std::uint32_t>(i);
+            }
+        }
+    }
+
+    m_leaf_count = leaf_count;
+    m_portals = portals;
+    m_portal_planes = std::move(portal_planes);
+    m_vertices = vertices;
+    m_leaf_portal_offsets = std::move(leaf_portal_offsets);
+    m_leaf_portal_list = std::move(leaf_portal_list);
+}
+
+void bsp::PortalFlow::flow(std::size_t from_leaf, const Eigen::Vector3f& eye, const math::Frustum* frustum,
+    std::vector<std::uint64_t>& out_leaves) const
+{
+    assert(eye.allFinite());
+
+    out_leaves.assign(utils::bitset_words(m_leaf_count), UINT64_C(0));
+
+    if(from_leaf >= m_leaf_count) {
+        return; // out of bounds
+    }
+
+    // Frames are reused by siblings at the same depth; all
+    // of them are created upfront so references stay valid
+    std::vector<FlowFrame> frames(FLOW_MAX_DEPTH + 1);
+    std::vector<std::uint64_t> on_path(out_leaves.size(), UINT64_C(0));
+
+    if(frustum) {
+        frames[0].planes.assign(frustum->planes().cbegin(), frustum->planes().cend());
+    }
+
+    flow_internal(from_leaf, eye, 0, frames, on_path, out_leaves);
+}
+
+void bsp::PortalFlow::flow_internal(std::size_t leaf, const Eigen::Vector3f& eye, std::size_t depth, std::vector<FlowFrame>& frames,
+    std::vector<std::uint64_t>& on_path, std::vector<std::uint64_t>& out_leaves) const
+{
+    out_leaves[leaf / 64] |= UINT64_C(1) << (leaf % 64);
+
+    if(depth >= FLOW_MAX_DEPTH) {
+        return;
+    }
+
+    on_path[leaf / 64] |= UINT64_C(1) << (leaf % 64);
+
+    const auto& frame = frames[depth];
+    auto& next = frames[depth + 1];
+
+    for(auto i = m_leaf_portal_offsets[leaf]; i < m_leaf_portal_offsets[leaf + 1]; ++i) {
+        auto portal_index = m_leaf_portal_list[i];
+        const auto& portal = m_portals[portal_index];
+
+        auto other = static_cast<std::size_t>((portal.front_leaf_index == leaf) ? portal.back_leaf_index : portal.front_leaf_index);
+
+        if(other >= m_leaf_count || (on_path[other / 64] & (UINT64_C(1) << (other % 64)))) {
+            continue;
+        }
+
+        next.polygon.assign(m_vertices.cbegin() + portal.portal_vertex_offset,
+            m_vertices.cbegin() + portal.portal_vertex_offset + portal.portal_vertex_count);
+
+        for(const auto& plane : frame.planes) {
+            clip_polygon(next.polygon, plane, next.scratch);
+            std::swap(next.polygon, next.scratch);
+
+            if(next.polygon.size() < 3) {
+                break;
+            }
+        }
+
+        if(next.polygon.size() < 3) {
+            continue;
+        }
+
+        auto portal_plane = m_portal_planes[portal_index];
+        auto eye_distance = portal_plane.signedDistance(eye);
+
+        if(std::abs(eye_distance) < FLOW_EPSILON) {
+            // The eye is right at the portal so it can't
+            // tell anything about directions to look at
+            next.planes = frame.planes;
+        }
+        else {
+            Eigen::Vector3f center = Eigen::Vector3f::Zero();
+
+            for(const auto& point : next.polygon) {
+                center += point;
+            }
+
+            center /= static_cast<float>(next.polygon.size());
+
+            next.planes.clear();
+
+            for(std::size_t j = 0; j < next.polygon.size(); ++j) {
+                const auto& a = next.polygon[j];
+                const auto& b = next.polygon[(j + 1) % next.polygon.size()];
+
+                Eigen::Vector3f normal = (a - eye).cross(b - eye);
+
+                if(normal.squaredNorm() < FLOW_EPSILON * FLOW_EPSILON) {
+                    continue; // degenerate edge
+                }
+
+                Eigen::Hyperplane<float, 3> plane(normal.normalized(), eye);
+
+                if(plane.signedDistance(center) < 0.0f) {
+                    plane.coeffs() = -plane.coeffs();
+                }
+
+                next.planes.push_back(plane);
+            }
+
+            // Whatever lies between the eye and the
+            // portal can't be seen through the portal
+            if(eye_distance > 0.0f) {
+                portal_plane.coeffs() = -portal_plane.coeffs();
+            }
+
+            next.planes.push_back(portal_plane);
+        }
+
+        flow_internal(other, eye, depth + 1, frames, on_path, out_leaves);
+    }
+
+    on_path[leaf / 64] &= ~(UINT64_C(1) << (leaf % 64));
+}
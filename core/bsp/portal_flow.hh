@@ -0,0 +1,75 @@
+#ifndef CORE_BSP_PORTAL_FLOW_HH
+#define CORE_BSP_PORTAL_FLOW_HH
+#pragma once
+
+#include "core/bsp/portal.hh"
+
+namespace bsp
+{
+class PVis;
+} // namespace bsp
+
+namespace math
+{
+class Frustum;
+} // namespace math
+
+namespace bsp
+{
+/// Runtime visibility through portals; starting from the viewer
+/// leaf, every portal is clipped against the current view volume
+/// and only portals that remain visible narrow the volume further
+/// and let the flow into the leaf behind them; the result is usually
+/// much tighter than the PVS, which has to account for every point
+/// of the viewer leaf and every direction at once
+class PortalFlow final {
+public:
+    constexpr std::size_t leaf_count(void) const noexcept;
+
+    /// Prepare portal data for queries; leaf indices are
+    /// the ones portals use, which is the bsp::Tree node index
+    /// @param pvis Portals and their geometry
+    /// @throws exceptions if any portal references vertices out of bounds
+    void set_pvis(const bsp::PVis& pvis);
+
+    /// Find leaves visible from a point
+    /// @param from_leaf Leaf the viewer is in
+    /// @param eye Viewer position
+    /// @param frustum View frustum or nullptr to look in every direction
+    /// @param out_leaves Output bitset of visible leaves, resized to fit leaf_count() bits
+    void flow(std::size_t from_leaf, const Eigen::Vector3f& eye, const math::Frustum* frustum,
+        std::vector<std::uint64_t>& out_leaves) const;
+
+private:
+    struct FlowFrame final {
+        std::vector<Eigen::Vector3f> polygon;
+        std::vector<Eigen::Vector3f> scratch;
+        std::vector<Eigen::Hyperplane<float, 3>> planes;
+    };
+
+    /// Recursive private implementation of flow()
+    /// @param leaf Leaf the flow has reached
+    /// @param eye Viewer position
+    /// @param depth Recursion depth, indexes frames
+    /// @param frames Per-depth scratch data; frames[depth].planes is the current view volume
+    /// @param on_path Bitset of leaves on the current path
+    /// @param out_leaves Output bitset of visible leaves
+    void flow_internal(std::size_t leaf, const Eigen::Vector3f& eye, std::size_t depth, std::vector<FlowFrame>& frames,
+        std::vector<std::uint64_t>& on_path, std::vector<std::uint64_t>& out_leaves) const;
+
+private:
+    std::size_t m_leaf_count { 0 };
+    std::vector<bsp::Portal> m_portals;
+    std::vector<Eigen::Hyperplane<float, 3>> m_portal_planes;
+    std::vector<Eigen::Vector3f> m_vertices;
+    std::vector<std::uint32_t> m_leaf_portal_offsets; ///< Where portals of every leaf start in m_leaf_portal_list
+    std::vector<std::uint32_t> m_leaf_portal_list;
+};
+} // namespace bsp
+
+constexpr std::size_t bsp::PortalFlow::leaf_count(void) const noexcept
+{
+    return m_leaf_count;
+}
+
+#endif
@@ -3,25 +3,60 @@
 #include "core/bsp/pvs.hh"
 
 #include "core/bsp/tree.hh"
+#include "core/exceptions.hh"
+#include "core/utils/bitset.hh"
 
 bool bsp::PVS::is_visible(std::size_t from_leaf, std::size_t target_leaf) const noexcept
 {
-    if(from_leaf >= m_visdata.size() || target_leaf == SIZE_MAX) {
+    if(from_leaf >= m_size || target_leaf == SIZE_MAX) {
         return true; // out of bounds, assume visible
     }
 
-    return m_visdata[from_leaf].contains(static_cast<std::uint32_t>(target_leaf));
+    if(target_leaf >= m_size) {
+        return false;
+    }
+
+    return m_rows[from_leaf * m_row_words + target_leaf / 64] & (UINT64_C(1) << (target_leaf % 64));
+}
+
+std::span<const std::uint64_t> bsp::PVS::row(std::size_t from_leaf) const noexcept
+{
+    if(from_leaf >= m_size) {
+        return {}; // out of bounds
+    }
+
+    return std::span<const std::uint64_t>(m_rows).subspan(from_leaf * m_row_words, m_row_words);
+}
+
+std::size_t bsp::PVS::count_visible(std::size_t from_leaf) const noexcept
+{
+    return utils::bitset_popcount(row(from_leaf));
+}
+
+void bsp::PVS::merge_rows(std::span<const std::size_t> from_leaves, std::span<std::uint64_t> out_row) const noexcept
+{
+    assert(out_row.size() >= m_row_words);
+
+    std::fill(out_row.begin(), out_row.end(), UINT64_C(0));
+
+    for(auto from_leaf : from_leaves) {
+        if(from_leaf < m_size) {
+            utils::bitset_or(out_row.first(m_row_words), row(from_leaf));
+        }
+    }
 }
 
 bool bsp::PVS::get_visible_leaves(std::size_t from_leaf, std::unordered_set<std::uint32_t>& out_leaves) const noexcept
 {
     out_leaves.clear();
 
-    if(from_leaf >= m_visdata.size()) {
+    if(from_leaf >= m_size) {
         return false; // out of bounds
     }
 
-    out_leaves = m_visdata[from_leaf];
+    for(auto leaf : utils::set_bits(row(from_leaf))) {
+        out_leaves.insert(static_cast<std::uint32_t>(leaf));
+    }
 
     return true;
 }
@@ -30,16 +65,55 @@ bool bsp::PVS::get_visible_leaves(std::size_t from_leaf, std::vector<std::uint32
 {
     out_leaves.clear();
 
-    if(from_leaf >= m_visdata.size()) {
+    if(from_leaf >= m_size) {
         return false; // out of bounds
     }
 
-    out_leaves.assign(m_visdata[from_leaf].cbegin(), m_visdata[from_leaf].cend());
+    for(auto leaf : utils::set_bits(row(from_leaf))) {
+        out_leaves.push_back(static_cast<std::uint32_t>(leaf));
+    }
 
     return true;
 }
 
-void bsp::PVS::set_visdata(std::vector<std::unordered_set<std::uint32_t>> visdata) noexcept
+void bsp::PVS::set_rows(std::size_t leafcnt, std::vector<std::uint64_t> rows)
 {
-    m_visdata = std::move(visdata);
+    auto row_words = utils::bitset_words(leafcnt);
+
+    qf::throw_if_fmt<std::invalid_argument>(rows.size() != leafcnt * row_words, "expected {} words of PVS rows, got {}",
+        leafcnt * row_words, rows.size());
+
+    // Bits past the last leaf would show up in
+    // counts and iteration so they're cleared here
+    if(leafcnt % 64) {
+        auto tail_mask = (UINT64_C(1) << (leafcnt % 64)) - UINT64_C(1);
+
+        for(std::size_t i = 0; i < leafcnt; ++i) {
+            rows[i * row_words + row_words - 1] &= tail_mask;
+        }
+    }
+
+    m_size = leafcnt;
+    m_row_words = row_words;
+    m_rows = std::move(rows);
+}
+
+void bsp::PVS::set_visdata(const std::vector<std::unordered_set<std::uint32_t>>& visdata)
+{
+    auto leafcnt = visdata.size();
+    auto row_words = utils::bitset_words(leafcnt);
+
+    std::vector<std::uint64_t> rows(leafcnt * row_words, UINT64_C(0));
+
+    for(std::size_t i = 0; i < leafcnt; ++i) {
+        for(auto leaf : visdata[i]) {
+            if(leaf < leafcnt) {
+                rows[i * row_words + leaf / 64] |= UINT64_C(1) << (leaf % 64);
+            }
+        }
+    }
+
+    m_size = leafcnt;
+    m_row_words = row_words;
+    m_rows = std::move(rows);
 }
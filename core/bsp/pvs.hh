@@ -14,15 +14,36 @@ namespace bsp
 /// A quote-unquote "lump" for potentially visible set (PVS) data; contains
 /// precomputed visibility information for each leaf in the BSP tree; this
 /// allows us to quickly determine which parts of the level are potentially
-/// visible from a given leaf; more complicated culling is done via bsp::PVis
+/// visible from a given leaf; more complicated culling is done via bsp::PVis;
+/// every row is a bitset of row_words() 64-bit words stored back to back
 class PVS final {
 public:
+    constexpr std::size_t size(void) const noexcept;
+    constexpr std::size_t row_words(void) const noexcept;
+    constexpr const std::vector<std::uint64_t>& rows(void) const noexcept;
+
     /// Checks if a BSP leaf is potentially visible from an another leaf
     /// @param from_leaf Leaf index from which we're looking
     /// @param target_leaf Leaf index which is to be checked for visibility
     /// @return True when target_leaf is potentially visible from from_leaf
     bool is_visible(std::size_t from_leaf, std::size_t target_leaf) const noexcept;
 
+    /// Gets the visibility row of a leaf
+    /// @param from_leaf Leaf index from which we're looking
+    /// @return Bitset of row_words() words or an empty span if from_leaf is out of bounds
+    std::span<const std::uint64_t> row(std::size_t from_leaf) const noexcept;
+
+    /// Counts leaves potentially visible from a given leaf
+    /// @param from_leaf Leaf index from which we're looking
+    /// @return Amount of visible leaves or zero if from_leaf is out of bounds
+    std::size_t count_visible(std::size_t from_leaf) const noexcept;
+
+    /// Merges rows of several leaves, for instance to get
+    /// everything that any of a group of viewers can see
+    /// @param from_leaves Leaf indices to merge rows of; out of bounds ones are ignored
+    /// @param out_row Output bitset, must be at least row_words() long
+    void merge_rows(std::span<const std::size_t> from_leaves, std::span<std::uint64_t> out_row) const noexcept;
+
     /// Gets the set of potentially visible leaves from a given leaf
     /// @param from_leaf Leaf index from which we're looking
     /// @param out_leaves Output set of leaf indices, will be cleared before filling
@@ -31,21 +52,41 @@ public:
 
     /// Gets the vector of potentially visible leaves from a given leaf as a vector
     /// @param from_leaf Leaf index from which we're looking
-    /// @param out_leaves Output vector of leaf indices, will be cleared before filling
+    /// @param out_leaves Output vector of leaf indices in ascending order, will be cleared before filling
     /// @return True if from_leaf is valid and out_leaves was filled, false if from_leaf is out of bounds and out_leaves was cleared
     bool get_visible_leaves(std::size_t from_leaf, std::vector<std::uint32_t>& out_leaves) const noexcept;
 
-    constexpr const std::vector<std::unordered_set<std::uint32_t>>& visdata(void) const noexcept;
-    void set_visdata(std::vector<std::unordered_set<std::uint32_t>> visdata) noexcept;
+    /// Replaces visibility data
+    /// @param leafcnt Amount of leaves
+    /// @param rows Bitsets for every leaf, row_words() words each
+    /// @throws exceptions if rows doesn't hold leafcnt rows
+    void set_rows(std::size_t leafcnt, std::vector<std::uint64_t> rows);
+
+    /// Replaces visibility data with per-leaf sets; kept
+    /// around for code that still builds visibility as sets
+    /// @param visdata Sets of visible leaves for every leaf
+    void set_visdata(const std::vector<std::unordered_set<std::uint32_t>>& visdata);
 
 private:
-    std::vector<std::unordered_set<std::uint32_t>> m_visdata;
+    std::size_t m_size { 0 };
+    std::size_t m_row_words { 0 };
+    std::vector<std::uint64_t> m_rows;
 };
 } // namespace bsp
 
-constexpr const std::vector<std::unordered_set<std::uint32_t>>& bsp::PVS::visdata(void) const noexcept
+constexpr std::size_t bsp::PVS::size(void) const noexcept
+{
+    return m_size;
+}
+
+constexpr std::size_t bsp::PVS::row_words(void) const noexcept
+{
+    return m_row_words;
+}
+
+constexpr const std::vector<std::uint64_t>& bsp::PVS::rows(void) const noexcept
 {
-    return m_visdata;
+    return m_rows;
 }
 
 #endif
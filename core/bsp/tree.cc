@@ -4,6 +4,7 @@
 
 #include "core/buffer.hh"
 #include "core/exceptions.hh"
+#include "core/math/plane.hh"
 
 void bsp::Tree::traverse_ftb(const Eigen::Vector3f& look, std::vector<std::size_t>& nodes) const noexcept
 {
@@ -33,6 +34,12 @@ std::size_t bsp::Tree::locate(const Eigen::Vector3f& point) const noexcept
 void bsp::Tree::set_planes(std::vector<Eigen::Hyperplane<float, 3>> planes) noexcept
 {
     m_planes = std::move(planes);
+
+    m_plane_types.resize(m_planes.size());
+
+    for(std::size_t i = 0; i < m_planes.size(); ++i) {
+        m_plane_types[i] = math::plane_type(m_planes[i].normal());
+    }
 }
 
 void bsp::Tree::set_nodes(std::vector<bsp::Node> nodes) noexcept
@@ -46,8 +53,7 @@ void bsp::Tree::traverse_internal_ftb(const Eigen::Vector3f& look, std::size_t i
         auto& node = m_nodes[index];
 
         if(auto chain = std::get_if<bsp::Chain>(&node)) {
-            auto& hyperplane = m_planes[chain->plane_index];
-            auto distance = hyperplane.signedDistance(look);
+            auto distance = plane_distance(chain->plane_index, look);
 
             if(distance < 0.0f) {
                 traverse_internal_ftb(look, chain->back_index, nodes);
@@ -72,8 +78,7 @@ void bsp::Tree::traverse_internal_btf(const Eigen::Vector3f& look, std::size_t i
         auto& node = m_nodes[index];
 
         if(auto chain = std::get_if<bsp::Chain>(&node)) {
-            auto& hyperplane = m_planes[chain->plane_index];
-            auto distance = hyperplane.signedDistance(look);
+            auto distance = plane_distance(chain->plane_index, look);
 
             if(distance < 0.0f) {
                 traverse_internal_btf(look, chain->front_index, nodes);
@@ -98,8 +103,7 @@ std::size_t bsp::Tree::locate_internal(const Eigen::Vector3f& point, std::size_t
         auto& node = m_nodes[index];
 
         if(auto chain = std::get_if<bsp::Chain>(&node)) {
-            auto& hyperplane = m_planes[chain->plane_index];
-            auto distance = hyperplane.signedDistance(point);
+            auto distance = plane_distance(chain->plane_index, point);
 
             if(distance < 0.0f) {
                 return locate_internal(point, chain->back_index);
@@ -115,3 +119,9 @@ std::size_t bsp::Tree::locate_internal(const Eigen::Vector3f& point, std::size_t
 
     return SIZE_MAX;
 }
+
+float bsp::Tree::plane_distance(std::size_t plane_index, const Eigen::Vector3f& point) const noexcept
+{
+    auto& hyperplane = m_planes[plane_index];
+    return math::plane_distance(hyperplane.normal(), hyperplane.offset(), m_plane_types[plane_index], point);
+}
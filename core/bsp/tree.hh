@@ -54,7 +54,15 @@ private:
     /// @return Leaf node index
     std::size_t locate_internal(const Eigen::Vector3f& point, std::size_t index) const noexcept;
 
+    /// Signed distance from a plane to a point; axial
+    /// planes are measured with a single component
+    /// @param plane_index Plane index
+    /// @param point The point to measure the distance to
+    /// @return Signed distance, positive in front of the plane
+    float plane_distance(std::size_t plane_index, const Eigen::Vector3f& point) const noexcept;
+
     std::vector<Eigen::Hyperplane<float, 3>> m_planes;
+    std::vector<std::uint8_t> m_plane_types;
     std::vector<bsp::Node> m_nodes;
 };
 } // namespace bsp
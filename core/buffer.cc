@@ -2,11 +2,114 @@
 
 #include "core/buffer.hh"
 
+#include "core/utils/endian.hh"
+
+template<typename T>
+concept span_value = std::is_arithmetic_v<T> || std::same_as<T, std::byte>;
+
+template<std::size_t Size>
+static void copy_big_endian(void* destination, const void* source, std::size_t count) noexcept
+{
+    if constexpr(Size == 1) {
+        std::memcpy(destination, source, count);
+    }
+    else if constexpr(Size == 2) {
+        utils::copy_big_endian_16(destination, source, count);
+    }
+    else if constexpr(Size == 4) {
+        utils::copy_big_endian_32(destination, source, count);
+    }
+    else {
+        static_assert(Size == 8, "unsupported value size");
+        utils::copy_big_endian_64(destination, source, count);
+    }
+}
+
+// Storage larger than this is left to the allocator; pooling
+// exists for small short-lived buffers, not for level saves
+constexpr static std::size_t POOL_MAX_CAPACITY = 256 * 1024;
+constexpr static std::size_t POOL_MAX_BUFFERS = 64;
+
+static std::mutex s_pool_mutex;
+static std::vector<std::vector<std::byte>> s_pool_storage;
+static std::vector<std::unique_ptr<std::vector<std::byte>>> s_pool_carriers;
+
+static std::vector<std::byte> acquire_storage(void)
+{
+    std::scoped_lock lock(s_pool_mutex);
+
+    if(s_pool_storage.empty()) {
+        return std::vector<std::byte>();
+    }
+
+    auto storage = std::move(s_pool_storage.back());
+    s_pool_storage.pop_back();
+    return storage;
+}
+
+static void release_storage(std::vector<std::byte>&& storage)
+{
+    if(storage.capacity() == 0 || storage.capacity() > POOL_MAX_CAPACITY) {
+        return;
+    }
+
+    std::scoped_lock lock(s_pool_mutex);
+
+    if(s_pool_storage.size() < POOL_MAX_BUFFERS) {
+        storage.clear();
+        s_pool_storage.push_back(std::move(storage));
+    }
+}
+
+// Carriers hold the storage of packets that are in flight;
+// they are recycled too so the handoff doesn't allocate
+static std::vector<std::byte>* acquire_carrier(void)
+{
+    std::scoped_lock lock(s_pool_mutex);
+
+    if(s_pool_carriers.empty()) {
+        return new std::vector<std::byte>();
+    }
+
+    auto carrier = s_pool_carriers.back().release();
+    s_pool_carriers.pop_back();
+    return carrier;
+}
+
+static void release_carrier(std::vector<std::byte>* carrier)
+{
+    release_storage(std::move(*carrier));
+
+    // Storage the pool didn't take is still inside the
+    // carrier and must not be kept alive along with it
+    carrier->clear();
+    carrier->shrink_to_fit();
+
+    std::scoped_lock lock(s_pool_mutex);
+
+    if(s_pool_carriers.size() < POOL_MAX_BUFFERS) {
+        s_pool_carriers.emplace_back(carrier);
+    }
+    else {
+        delete carrier;
+    }
+}
+
+static void free_packet_storage(ENetPacket* packet)
+{
+    release_carrier(reinterpret_cast<std::vector<std::byte>*>(packet->userData));
+}
+
 ReadBuffer::ReadBuffer(const ReadBuffer& other)
 {
     reset(other.data(), other.size());
 }
 
+ReadBuffer::ReadBuffer(ReadBuffer&& other) noexcept
+{
+    *this = std::move(other);
+}
+
 ReadBuffer::ReadBuffer(const void* data, std::size_t size)
 {
     assert(data);
@@ -28,14 +131,38 @@ ReadBuffer::ReadBuffer(PHYSFS_File* file)
     reset(file);
 }
 
+ReadBuffer& ReadBuffer::operator=(ReadBuffer&& other) noexcept
+{
+    if(this != &other) {
+        // Moving a vector keeps its storage in place,
+        // so m_data stays valid for owning buffers too
+        m_vector = std::move(other.m_vector);
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_position = other.m_position;
+
+        other.m_vector.clear();
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_position = 0;
+    }
+
+    return *this;
+}
+
 std::size_t ReadBuffer::size(void) const
 {
-    return m_vector.size();
+    return m_size;
 }
 
 const std::byte* ReadBuffer::data(void) const
 {
-    return m_vector.data();
+    return m_data;
+}
+
+bool ReadBuffer::is_borrowed(void) const
+{
+    return m_data && m_data != m_vector.data();
 }
 
 void ReadBuffer::reset(const void* data, std::size_t size)
@@ -44,6 +171,8 @@ void ReadBuffer::reset(const void* data, std::size_t size)
 
     auto bytes = reinterpret_cast<const std::byte*>(data);
     m_vector.assign(bytes, bytes + size);
+    m_data = m_vector.data();
+    m_size = m_vector.size();
     m_position = 0;
 }
 
@@ -53,6 +182,8 @@ void ReadBuffer::reset(const ENetPacket* packet)
 
     auto bytes_ptr = reinterpret_cast<const std::byte*>(packet->data);
     m_vector.assign(bytes_ptr, bytes_ptr + packet->dataLength);
+    m_data = m_vector.data();
+    m_size = m_vector.size();
     m_position = 0;
 }
 
@@ -61,17 +192,47 @@ void ReadBuffer::reset(PHYSFS_File* file)
     assert(file);
 
     m_vector.resize(PHYSFS_fileLength(file));
+    m_data = m_vector.data();
+    m_size = m_vector.size();
     m_position = 0;
 
     PHYSFS_seek(file, 0);
-    PHYSFS_readBytes(file, m_vector.data(), m_vector.size());
+    PHYSFS_readBytes(file, m_vector.data(), m_size);
+}
+
+void ReadBuffer::borrow(const void* data, std::size_t size)
+{
+    assert(data || size == 0);
+
+    m_vector.clear();
+    m_data = reinterpret_cast<const std::byte*>(data);
+    m_size = size;
+    m_position = 0;
+}
+
+void ReadBuffer::borrow(const ENetPacket* packet)
+{
+    assert(packet);
+
+    borrow(packet->data, packet->dataLength);
+}
+
+ReadBuffer ReadBuffer::slice(std::size_t offset, std::size_t size) const
+{
+    ReadBuffer result;
+
+    if(offset <= m_size && size <= m_size - offset) {
+        result.borrow(m_data + offset, size);
+    }
+
+    return result;
 }
 
 template<>
 std::byte ReadBuffer::read<std::byte>(void)
 {
-    if(m_position < m_vector.size()) {
-        auto result = m_vector[m_position];
+    if(m_position < m_size) {
+        auto result = m_data[m_position];
         m_position += 1;
         return result;
     }
@@ -83,8 +244,8 @@ std::byte ReadBuffer::read<std::byte>(void)
 template<>
 std::uint8_t ReadBuffer::read<std::uint8_t>(void)
 {
-    if((m_position + 1) <= m_vector.size()) {
-        auto result = static_cast<std::uint8_t>(m_vector[m_position]);
+    if((m_position + 1) <= m_size) {
+        auto result = static_cast<std::uint8_t>(m_data[m_position]);
         m_position += 1;
         return result;
     }
@@ -96,10 +257,10 @@ std::uint8_t ReadBuffer::read<std::uint8_t>(void)
 template<>
 std::uint16_t ReadBuffer::read<std::uint16_t>(void)
 {
-    if((m_position + 2) <= m_vector.size()) {
+    if((m_position + 2) <= m_size) {
         auto result = UINT16_C(0x0000);
-        result |= (UINT16_C(0x00FF) & static_cast<std::uint16_t>(m_vector[m_position + 0])) << 8;
-        result |= (UINT16_C(0x00FF) & static_cast<std::uint16_t>(m_vector[m_position + 1])) << 0;
+        result |= (UINT16_C(0x00FF) & static_cast<std::uint16_t>(m_data[m_position + 0])) << 8;
+        result |= (UINT16_C(0x00FF) & static_cast<std::uint16_t>(m_data[m_position + 1])) << 0;
         m_position += 2;
         return result;
     }
@@ -111,12 +272,12 @@ std::uint16_t ReadBuffer::read<std::uint16_t>(void)
 template<>
 std::uint32_t ReadBuffer::read<std::uint32_t>(void)
 {
-    if((m_position + 4) <= m_vector.size()) {
+    if((m_position + 4) <= m_size) {
         auto result = UINT32_C(0x00000000);
-        result |= (UINT32_C(0x000000FF) & static_cast<std::uint32_t>(m_vector[m_position + 0])) << 24;
-        result |= (UINT32_C(0x000000FF) & static_cast<std::uint32_t>(m_vector[m_position + 1])) << 16;
-        result |= (UINT32_C(0x000000FF) & static_cast<std::uint32_t>(m_vector[m_position + 2])) << 8;
-        result |= (UINT32_C(0x000000FF) & static_cast<std::uint32_t>(m_vector[m_position + 3])) << 0;
+        result |= (UINT32_C(0x000000FF) & static_cast<std::uint32_t>(m_data[m_position + 0])) << 24;
+        result |= (UINT32_C(0x000000FF) & static_cast<std::uint32_t>(m_data[m_position + 1])) << 16;
+        result |= (UINT32_C(0x000000FF) & static_cast<std::uint32_t>(m_data[m_position + 2])) << 8;
+        result |= (UINT32_C(0x000000FF) & static_cast<std::uint32_t>(m_data[m_position + 3])) << 0;
         m_position += 4;
         return result;
     }
@@ -128,16 +289,16 @@ std::uint32_t ReadBuffer::read<std::uint32_t>(void)
 template<>
 std::uint64_t ReadBuffer::read<std::uint64_t>(void)
 {
-    if((m_position + 8) <= m_vector.size()) {
+    if((m_position + 8) <= m_size) {
         auto result = UINT64_C(0x0000000000000000);
-        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_vector[m_position + 0])) << 56;
-        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_vector[m_position + 1])) << 48;
-        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_vector[m_position + 2])) << 40;
-        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_vector[m_position + 3])) << 32;
-        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_vector[m_position + 4])) << 24;
-        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_vector[m_position + 5])) << 16;
-        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_vector[m_position + 6])) << 8;
-        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_vector[m_position + 7])) << 0;
+        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_data[m_position + 0])) << 56;
+        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_data[m_position + 1])) << 48;
+        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_data[m_position + 2])) << 40;
+        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_data[m_position + 3])) << 32;
+        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_data[m_position + 4])) << 24;
+        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_data[m_position + 5])) << 16;
+        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_data[m_position + 6])) << 8;
+        result |= (UINT64_C(0x00000000000000FF) & static_cast<std::uint64_t>(m_data[m_position + 7])) << 0;
         m_position += 8;
         return result;
     }
@@ -183,8 +344,8 @@ std::string ReadBuffer::read<std::string>(void)
     result.resize(read<std::uint16_t>());
 
     for(std::size_t i = 0; i < result.size(); ++i) {
-        if(m_position < m_vector.size()) {
-            result[i] = static_cast<char>(m_vector[m_position]);
+        if(m_position < m_size) {
+            result[i] = static_cast<char>(m_data[m_position]);
         }
 
         m_position += 1;
@@ -196,18 +357,67 @@ std::string ReadBuffer::read<std::string>(void)
 void ReadBuffer::read(void* buffer, std::size_t size)
 {
     auto bytes = reinterpret_cast<std::byte*>(buffer);
-    auto amount_to_read = std::min(size, m_vector.size() - m_position);
+    auto amount_to_read = (m_position < m_size) ? std::min(size, m_size - m_position) : 0;
 
     if(amount_to_read > 0) {
-        std::copy(m_vector.cbegin() + m_position, m_vector.cbegin() + m_position + amount_to_read, bytes);
+        std::copy(m_data + m_position, m_data + m_position + amount_to_read, bytes);
+    }
+
+    m_position += size;
+}
+
+std::span<const std::byte> ReadBuffer::read_view(std::size_t size)
+{
+    if((m_position + size) <= m_size) {
+        std::span<const std::byte> result(m_data + m_position, size);
+        m_position += size;
+        return result;
     }
 
     m_position += size;
+    return std::span<const std::byte>();
+}
+
+template<typename T>
+void ReadBuffer::read_span(std::span<T> values)
+{
+    static_assert(span_value<T>, "unsupported value type");
+
+    if((m_position + values.size_bytes()) <= m_size) {
+        copy_big_endian<sizeof(T)>(values.data(), m_data + m_position, values.size());
+    }
+    else {
+        std::fill(values.begin(), values.end(), T(0));
+    }
+
+    m_position += values.size_bytes();
+}
+
+template void ReadBuffer::read_span<std::byte>(std::span<std::byte> values);
+template void ReadBuffer::read_span<std::uint8_t>(std::span<std::uint8_t> values);
+template void ReadBuffer::read_span<std::uint16_t>(std::span<std::uint16_t> values);
+template void ReadBuffer::read_span<std::uint32_t>(std::span<std::uint32_t> values);
+template void ReadBuffer::read_span<std::uint64_t>(std::span<std::uint64_t> values);
+template void ReadBuffer::read_span<std::int8_t>(std::span<std::int8_t> values);
+template void ReadBuffer::read_span<std::int16_t>(std::span<std::int16_t> values);
+template void ReadBuffer::read_span<std::int32_t>(std::span<std::int32_t> values);
+template void ReadBuffer::read_span<std::int64_t>(std::span<std::int64_t> values);
+template void ReadBuffer::read_span<float>(std::span<float> values);
+
+WriteBuffer::WriteBuffer(void)
+{
+    m_vector = acquire_storage();
 }
 
 WriteBuffer::WriteBuffer(const WriteBuffer& other)
 {
-    m_vector = other.m_vector;
+    m_vector = acquire_storage();
+    m_vector.assign(other.m_vector.cbegin(), other.m_vector.cend());
+}
+
+WriteBuffer::~WriteBuffer(void)
+{
+    release_storage(std::move(m_vector));
 }
 
 std::size_t WriteBuffer::size(void) const
@@ -319,6 +529,28 @@ void WriteBuffer::write<std::string_view>(const std::string_view value)
     }
 }
 
+template<typename T>
+void WriteBuffer::write_span(std::span<const T> values)
+{
+    static_assert(span_value<T>, "unsupported value type");
+
+    auto offset = m_vector.size();
+    m_vector.resize(offset + values.size_bytes());
+
+    copy_big_endian<sizeof(T)>(m_vector.data() + offset, values.data(), values.size());
+}
+
+template void WriteBuffer::write_span<std::byte>(std::span<const std::byte> values);
+template void WriteBuffer::write_span<std::uint8_t>(std::span<const std::uint8_t> values);
+template void WriteBuffer::write_span<std::uint16_t>(std::span<const std::uint16_t> values);
+template void WriteBuffer::write_span<std::uint32_t>(std::span<const std::uint32_t> values);
+template void WriteBuffer::write_span<std::uint64_t>(std::span<const std::uint64_t> values);
+template void WriteBuffer::write_span<std::int8_t>(std::span<const std::int8_t> values);
+template void WriteBuffer::write_span<std::int16_t>(std::span<const std::int16_t> values);
+template void WriteBuffer::write_span<std::int32_t>(std::span<const std::int32_t> values);
+template void WriteBuffer::write_span<std::int64_t>(std::span<const std::int64_t> values);
+template void WriteBuffer::write_span<float>(std::span<const float> values);
+
 PHYSFS_File* WriteBuffer::to_file(std::string_view path, bool append) const
 {
     std::string path_unfucked(path);
@@ -342,3 +574,24 @@ ENetPacket* WriteBuffer::to_packet(enet_uint32 flags) const
 {
     return enet_packet_create(m_vector.data(), m_vector.size(), flags);
 }
+
+ENetPacket* WriteBuffer::release_packet(enet_uint32 flags)
+{
+    auto carrier = acquire_carrier();
+    carrier->swap(m_vector);
+
+    auto packet = enet_packet_create(carrier->data(), carrier->size(), flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+
+    if(packet == nullptr) {
+        carrier->swap(m_vector);
+        release_carrier(carrier);
+        return nullptr;
+    }
+
+    packet->userData = carrier;
+    packet->freeCallback = &free_packet_storage;
+
+    m_vector = acquire_storage();
+
+    return packet;
+}
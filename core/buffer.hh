@@ -2,43 +2,93 @@
 #define CORE_IO_BUFFER_HH
 #pragma once
 
+/// Big-endian reader over a chunk of memory; the buffer either owns
+/// a copy of the data (reset) or borrows memory owned by someone else
+/// (borrow, slice), both modes decode exactly the same way; borrowed
+/// memory, be it an ENet packet, a memory-mapped file or another buffer,
+/// must outlive the buffer or stay valid until the next reset or borrow,
+/// copying a buffer always produces an owning copy of the data
 class ReadBuffer final {
 public:
     ReadBuffer(void) = default;
     explicit ReadBuffer(const ReadBuffer& other);
+    ReadBuffer(ReadBuffer&& other) noexcept;
     explicit ReadBuffer(const void* data, std::size_t size);
     explicit ReadBuffer(const ENetPacket* packet);
     explicit ReadBuffer(PHYSFS_File* file);
     virtual ~ReadBuffer(void) = default;
 
+    ReadBuffer& operator=(ReadBuffer&& other) noexcept;
+
     std::size_t size(void) const;
     const std::byte* data(void) const;
+    bool is_borrowed(void) const;
 
     void reset(const void* data, std::size_t size);
     void reset(const ENetPacket* packet);
     void reset(PHYSFS_File* file);
 
+    /// Read directly from memory owned by someone else without copying
+    /// it; the memory must stay valid until the buffer is reset or destroyed
+    /// @param data Pointer to the borrowed memory
+    /// @param size Size of the borrowed memory in bytes
+    void borrow(const void* data, std::size_t size);
+
+    /// Read directly from a received packet without copying its
+    /// payload; the packet must not be destroyed while the buffer is in use
+    /// @param packet Borrowed packet
+    void borrow(const ENetPacket* packet);
+
+    /// Get a borrowed view of a part of this buffer; the view
+    /// has its own read position and is valid for as long as the
+    /// memory this buffer reads from is valid
+    /// @param offset Offset of the view in bytes
+    /// @param size Size of the view in bytes
+    /// @return Borrowed buffer or an empty one if the range is out of bounds
+    ReadBuffer slice(std::size_t offset, std::size_t size) const;
+
     constexpr void rewind(void);
     constexpr bool is_ended(void) const;
+    constexpr std::size_t remaining(void) const;
 
     void read(void* buffer, std::size_t size);
 
+    /// Get a view of the next bytes in the buffer and skip past them
+    /// @param size Amount of bytes to view
+    /// @return View into the buffer or an empty span if there isn't enough data left
+    std::span<const std::byte> read_view(std::size_t size);
+
     template<typename T>
     T read(void);
 
+    /// Read an array of big-endian values in one go; values
+    /// are zeroed if there isn't enough data left in the buffer
+    /// @param values Output values
+    template<typename T>
+    void read_span(std::span<T> values);
+
+    template<typename T, std::size_t N>
+    void read_span(std::array<T, N>& values);
+
     template<typename T>
     ReadBuffer& operator>>(T& value);
 
 private:
     std::vector<std::byte> m_vector;
-    std::size_t m_position;
+    const std::byte* m_data { nullptr };
+    std::size_t m_size { 0 };
+    std::size_t m_position { 0 };
 };
 
+/// Big-endian writer; the underlying storage is taken from a shared
+/// pool on construction and given back on destruction, so buffers that
+/// are created every tick (snapshots, messages) stop reallocating once
+/// the pool warms up; reset() keeps the storage for reuse as well
 class WriteBuffer final {
 public:
-    WriteBuffer(void) = default;
+    WriteBuffer(void);
     explicit WriteBuffer(const WriteBuffer& other);
-    virtual ~WriteBuffer(void) = default;
+    virtual ~WriteBuffer(void);
 
     std::size_t size(void) const;
     const std::byte* data(void) const;
@@ -51,12 +101,27 @@ public:
     template<typename T>
     void write(const T value);
 
+    /// Write an array of values as big-endian in one go
+    /// @param values Input values
+    template<typename T>
+    void write_span(std::span<const T> values);
+
+    template<typename T, std::size_t N>
+    void write_span(const std::array<T, N>& values);
+
     template<typename T>
     WriteBuffer& operator<<(const T value);
 
     PHYSFS_File* to_file(std::string_view path, bool append = false) const;
     ENetPacket* to_packet(enet_uint32 flags = ENET_PACKET_FLAG_RELIABLE) const;
 
+    /// Hand the written data over to ENet as packet memory without
+    /// copying it; the storage returns to the pool once ENet destroys
+    /// the packet and the buffer continues empty with fresh pooled storage
+    /// @param flags ENet packet flags, ENET_PACKET_FLAG_NO_ALLOCATE is implied
+    /// @return A packet or nullptr if ENet failed to allocate one
+    ENetPacket* release_packet(enet_uint32 flags = ENET_PACKET_FLAG_RELIABLE);
+
 private:
     std::vector<std::byte> m_vector;
 };
@@ -68,7 +133,18 @@ constexpr void ReadBuffer::rewind(void)
 
 constexpr bool ReadBuffer::is_ended(void) const
 {
-    return m_position >= m_vector.size();
+    return m_position >= m_size;
+}
+
+constexpr std::size_t ReadBuffer::remaining(void) const
+{
+    return (m_position < m_size) ? (m_size - m_position) : 0;
+}
+
+template<typename T, std::size_t N>
+void ReadBuffer::read_span(std::array<T, N>& values)
+{
+    read_span<T>(std::span<T>(values));
 }
 
 template<typename T>
@@ -78,6 +154,12 @@ ReadBuffer& ReadBuffer::operator>>(T& value)
     return *this;
 }
 
+template<typename T, std::size_t N>
+void WriteBuffer::write_span(const std::array<T, N>& values)
+{
+    write_span<T>(std::span<const T>(values));
+}
+
 template<typename T>
 WriteBuffer& WriteBuffer::operator<<(const T value)
 {
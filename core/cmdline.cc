@@ -21,7 +21,7 @@ static std::string_view get_option(std::string_view argv_string)
 {
     std::size_t i;
 
-    for(i = 0; argv_string[0] == OPTION_PREFIX; ++i) {
+    for(i = 0; i < argv_string.size() && argv_string[i] == OPTION_PREFIX; ++i) {
         // empty
     }
 
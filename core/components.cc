@@ -2,35 +2,56 @@
 
 #include "core/components.hh"
 
+#include "core/buffer.hh"
+#include "core/exceptions.hh"
+
 struct ComponentInfo final {
     std::string component_name;
+    entt::id_type storage_id;
     components::serialize_fn serialize_fn;
     components::deserialize_fn deserialize_func;
+    components::encode_fn encode_fn;
+    components::decode_fn decode_fn;
 };
 
 static std::vector<ComponentInfo> s_registered_components;
+static std::unordered_map<std::string, std::size_t> s_component_indices;
 
-static const ComponentInfo* find_component_info(std::string_view name)
+static const ComponentInfo* find_component_info(const std::string& name)
 {
-    for(const auto& info : s_registered_components) {
-        if(info.component_name == name) {
-            return &info;
-        }
+    auto it = s_component_indices.find(name);
+
+    if(it == s_component_indices.cend()) {
+        return nullptr;
     }
 
-    return nullptr;
+    return &s_registered_components[it->second];
+}
+
+std::uint32_t components::register_component(std::string_view name, serialize_fn serializer, deserialize_fn deserializer)
+{
+    return register_component(name, entt::id_type(), std::move(serializer), std::move(deserializer), nullptr, nullptr);
 }
 
-void components::register_component(std::string_view name, serialize_fn serializer, deserialize_fn deserializer)
+std::uint32_t components::register_component(std::string_view name, entt::id_type storage_id, serialize_fn serializer,
+    deserialize_fn deserializer, encode_fn encoder, decode_fn decoder)
 {
-    assert(nullptr == find_component_info(name));
+    assert(!s_component_indices.contains(std::string(name)));
 
     ComponentInfo info;
     info.component_name = name;
+    info.storage_id = storage_id;
     info.serialize_fn = std::move(serializer);
     info.deserialize_func = std::move(deserializer);
+    info.encode_fn = std::move(encoder);
+    info.decode_fn = std::move(decoder);
+
+    auto component_id = static_cast<std::uint32_t>(s_registered_components.size());
 
+    s_component_indices.emplace(info.component_name, s_registered_components.size());
     s_registered_components.emplace_back(std::move(info));
+
+    return component_id;
 }
 
 JSON_Value* components::serialize_entity(const entt::registry& registry, entt::entity entity)
@@ -84,3 +105,169 @@ void components::deserialize_entity(entt::registry& registry, entt::entity entit
         info->deserialize_func(registry, entity, componentv);
     }
 }
+
+void components::encode_registry(const entt::registry& registry, WriteBuffer& buffer)
+{
+    std::vector<std::uint32_t> entity_table;
+    std::vector<std::uint32_t> entity_indices;
+
+    for(auto [entity] : registry.view<entt::entity>().each()) {
+        auto slot = static_cast<std::size_t>(entt::to_entity(entity));
+
+        if(slot >= entity_indices.size()) {
+            entity_indices.resize(slot + 1, UINT32_MAX);
+        }
+
+        entity_indices[slot] = static_cast<std::uint32_t>(entity_table.size());
+        entity_table.push_back(static_cast<std::uint32_t>(entt::to_integral(entity)));
+    }
+
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(entity_table.size()));
+    buffer.write_span<std::uint32_t>(entity_table);
+
+    std::vector<std::uint32_t> encodable;
+
+    for(std::size_t i = 0; i < s_registered_components.size(); ++i) {
+        const auto& info = s_registered_components[i];
+
+        if(info.encode_fn && registry.storage(info.storage_id)) {
+            encodable.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+
+    // Numeric identifiers depend on the registration order of
+    // the build that wrote them; names are written only once, in
+    // a table the reader matches against its own registrations
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(encodable.size()));
+
+    for(auto component_id : encodable) {
+        buffer.write<std::uint32_t>(component_id);
+        buffer.write<std::string_view>(s_registered_components[component_id].component_name);
+    }
+
+    std::vector<entt::entity> entities;
+    std::vector<std::uint32_t> indices;
+    WriteBuffer column;
+
+    for(auto component_id : encodable) {
+        const auto info = &s_registered_components[component_id];
+
+        entities.clear();
+        indices.clear();
+        column.reset();
+
+        for(auto entity : *registry.storage(info->storage_id)) {
+            auto slot = static_cast<std::size_t>(entt::to_entity(entity));
+
+            if(slot < entity_indices.size() && entity_indices[slot] != UINT32_MAX && registry.valid(entity)) {
+                entities.push_back(entity);
+                indices.push_back(entity_indices[slot]);
+            }
+        }
+
+        info->encode_fn(registry, entities, column);
+
+        buffer.write<std::uint32_t>(component_id);
+        buffer.write<std::uint32_t>(static_cast<std::uint32_t>(indices.size()));
+        buffer.write_span<std::uint32_t>(indices);
+        buffer.write<std::uint32_t>(static_cast<std::uint32_t>(column.size()));
+        buffer.write(column);
+    }
+}
+
+void components::decode_registry(entt::registry& registry, ReadBuffer& buffer)
+{
+    auto entitycnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+
+    qf::throw_if<std::runtime_error>(entitycnt * sizeof(std::uint32_t) > buffer.remaining(), "unexpected end-of-file");
+
+    std::vector<std::uint32_t> entity_table(entitycnt);
+    buffer.read_span<std::uint32_t>(entity_table);
+
+    std::vector<entt::entity> entity_list;
+    entity_list.reserve(entitycnt);
+
+    for(auto entity_value : entity_table) {
+        auto entity_request = static_cast<entt::entity>(entity_value);
+        auto entity = registry.create(entity_request);
+        qf::throw_if_not<std::runtime_error>(entity_request == entity, "entity id mismatch");
+
+        entity_list.push_back(entity);
+    }
+
+    auto componentcnt = buffer.read<std::uint32_t>();
+
+    // Identifiers in the table are the writer's; each is resolved
+    // to a local component once, nullptr for the ones to skip
+    std::unordered_map<std::uint32_t, const ComponentInfo*> component_table;
+    std::unordered_set<const ComponentInfo*> resolved;
+
+    for(std::uint32_t i = 0; i < componentcnt; ++i) {
+        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+
+        auto component_id = buffer.read<std::uint32_t>();
+        auto component_name = buffer.read<std::string>();
+        auto info = find_component_info(component_name);
+
+        if(info == nullptr) {
+            LOG_WARNING("unknown component: {}", component_name);
+        }
+        else if(!info->decode_fn) {
+            LOG_WARNING("non-decodable component: {}", component_name);
+
+            info = nullptr;
+        }
+        else {
+            qf::throw_if_fmt<std::runtime_error>(!resolved.insert(info).second, "component {} present twice", component_name);
+        }
+
+        qf::throw_if_fmt<std::runtime_error>(!component_table.emplace(component_id, info).second, "component id {} present twice",
+            component_id);
+    }
+
+    std::unordered_set<std::uint32_t> decoded;
+    std::vector<std::uint32_t> indices;
+    std::vector<entt::entity> entities;
+
+    for(std::uint32_t i = 0; i < componentcnt; ++i) {
+        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+
+        auto component_id = buffer.read<std::uint32_t>();
+        auto count = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+
+        qf::throw_if<std::runtime_error>(count * sizeof(std::uint32_t) > buffer.remaining(), "unexpected end-of-file");
+
+        indices.resize(count);
+        buffer.read_span<std::uint32_t>(indices);
+
+        auto column_size = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+        auto column_bytes = buffer.read_view(column_size);
+
+        qf::throw_if<std::runtime_error>(column_bytes.size() != column_size, "unexpected end-of-file");
+
+        auto entry = component_table.find(component_id);
+
+        qf::throw_if_fmt<std::runtime_error>(entry == component_table.cend(), "component id {} is not in the table", component_id);
+        qf::throw_if_fmt<std::runtime_error>(!decoded.insert(component_id).second, "component id {} present twice", component_id);
+
+        auto info = entry->second;
+
+        if(info == nullptr) {
+            continue;
+        }
+
+        entities.clear();
+        entities.reserve(count);
+
+        for(auto index : indices) {
+            qf::throw_if<std::runtime_error>(index >= entitycnt, "entity index out of bounds");
+
+            entities.push_back(entity_list[index]);
+        }
+
+        ReadBuffer column;
+        column.borrow(column_bytes.data(), column_bytes.size());
+
+        info->decode_fn(registry, entities, column);
+    }
+}
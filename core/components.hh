@@ -9,11 +9,26 @@ namespace components
 {
 using serialize_fn = std::function<JSON_Value*(const entt::registry& registry, entt::entity entity)>;
 using deserialize_fn = std::function<void(entt::registry& registry, entt::entity entity, const JSON_Value* jsonv)>;
+using encode_fn = std::function<void(const entt::registry& registry, std::span<const entt::entity> entities, WriteBuffer& buffer)>;
+using decode_fn = std::function<void(entt::registry& registry, std::span<const entt::entity> entities, ReadBuffer& buffer)>;
 } // namespace components
 
 namespace components
 {
-void register_component(std::string_view name, serialize_fn serializer, deserialize_fn deserializer);
+std::uint32_t register_component(std::string_view name, serialize_fn serializer, deserialize_fn deserializer);
+
+/// Register a component that can also be stored in binary form;
+/// the encoder writes values of every listed entity back to back,
+/// the decoder reads them back in the very same order
+/// @param name Component name, used to match components between builds
+/// @param storage_id Identifier of the component storage, usually entt::type_hash<T>::value()
+/// @param serializer JSON serializer
+/// @param deserializer JSON deserializer
+/// @param encoder Binary encoder
+/// @param decoder Binary decoder
+/// @return Numeric component identifier, which keys the component's column in binary form
+std::uint32_t register_component(std::string_view name, entt::id_type storage_id, serialize_fn serializer,
+    deserialize_fn deserializer, encode_fn encoder, decode_fn decoder);
 } // namespace components
 
 namespace components
@@ -22,4 +37,21 @@ JSON_Value* serialize_entity(const entt::registry& registry, entt::entity entity
 void deserialize_entity(entt::registry& registry, entt::entity entity, const JSON_Value* jsonv);
 } // namespace components
 
+namespace components
+{
+/// Write every entity of a registry in binary form; a table maps
+/// numeric component identifiers to names once, then components are
+/// written one after another, each as a single column of values
+/// @param registry Registry to encode
+/// @param buffer Output buffer
+void encode_registry(const entt::registry& registry, WriteBuffer& buffer);
+
+/// Read entities written by encode_registry; components
+/// that are not registered or lack a decoder are skipped
+/// @param registry Registry to decode into
+/// @param buffer Input buffer
+/// @throws exceptions if the data is malformed
+void decode_registry(entt::registry& registry, ReadBuffer& buffer);
+} // namespace components
+
 #endif
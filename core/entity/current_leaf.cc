@@ -2,8 +2,10 @@
 
 #include "core/entity/current_leaf.hh"
 
+#include "core/buffer.hh"
 #include "core/components.hh"
 #include "core/entity/transform.hh"
+#include "core/exceptions.hh"
 #include "core/level/level.hh"
 
 static JSON_Value* serialize_current_leaf(const entt::registry& registry, entt::entity entity)
@@ -28,20 +30,115 @@ static void deserialize_current_leaf(entt::registry& registry, entt::entity enti
     registry.emplace_or_replace<CurrentLeaf>(entity, static_cast<std::int32_t>(leaf_index));
 }
 
+static void encode_current_leaves(const entt::registry& registry, std::span<const entt::entity> entities, WriteBuffer& buffer)
+{
+    std::vector<std::int32_t> values;
+    values.reserve(entities.size());
+
+    for(auto entity : entities) {
+        values.push_back(registry.get<CurrentLeaf>(entity).leaf_index());
+    }
+
+    buffer.write_span<std::int32_t>(values);
+}
+
+static void decode_current_leaves(entt::registry& registry, std::span<const entt::entity> entities, ReadBuffer& buffer)
+{
+    qf::throw_if<std::runtime_error>(entities.size() * sizeof(std::int32_t) > buffer.remaining(), "unexpected end-of-file");
+
+    std::vector<std::int32_t> values(entities.size());
+    buffer.read_span<std::int32_t>(values);
+
+    std::vector<CurrentLeaf> current_leaves;
+    current_leaves.reserve(values.size());
+
+    for(auto leaf_index : values) {
+        current_leaves.emplace_back(leaf_index);
+    }
+
+    registry.insert<CurrentLeaf>(entities.begin(), entities.end(), current_leaves.cbegin());
+}
+
 void CurrentLeaf::register_component(void)
 {
-    components::register_component("current_leaf", &serialize_current_leaf, &deserialize_current_leaf);
+    components::register_component("current_leaf", entt::type_hash<CurrentLeaf>::value(), &serialize_current_leaf,
+        &deserialize_current_leaf, &encode_current_leaves, &decode_current_leaves);
 }
 
 void CurrentLeaf::fixed_update(Level& level)
 {
     auto& registry = level.registry();
+    auto& stats = registry.ctx().emplace<CurrentLeafStats>();
+
+    auto tracked_view = registry.view<Transform, CurrentLeaf>();
+
+    for(auto [entity, transform, current_leaf] : tracked_view.each()) {
+        auto position = transform.position();
+
+        stats.lookups += 1;
+
+        if((position - current_leaf.m_anchor).squaredNorm() < current_leaf.m_clearance * current_leaf.m_clearance) {
+            stats.clearance_hits += 1;
+            continue;
+        }
+
+        float clearance;
+        auto leaf_index = level.find_leaf_index(position, current_leaf.m_leaf_index, clearance);
 
-    auto view = registry.view<Transform>();
+        if(leaf_index == current_leaf.m_leaf_index) {
+            // The lookup cache isn't something anyone
+            // listens to so it's updated without signals
+            current_leaf.m_anchor = position;
+            current_leaf.m_clearance = clearance;
 
-    for(auto [entity, transform] : view.each()) {
-        registry.emplace_or_replace<CurrentLeaf>(entity, level.find_leaf_index(transform.position()));
+            stats.hint_hits += 1;
+            continue;
+        }
+
+        registry.patch<CurrentLeaf>(entity, [&](CurrentLeaf& value) {
+            value.m_leaf_index = leaf_index;
+            value.m_anchor = position;
+            value.m_clearance = clearance;
+        });
+
+        stats.leaf_changes += 1;
+    }
+
+    // Entities that don't have a leaf yet are
+    // located all at once from the root node
+    auto untracked_view = registry.view<Transform>(entt::exclude<CurrentLeaf>);
+
+    std::vector<entt::entity> entities;
+    std::vector<Eigen::Vector3f> positions;
+
+    for(auto [entity, transform] : untracked_view.each()) {
+        entities.push_back(entity);
+        positions.push_back(transform.position());
+    }
+
+    std::vector<std::int32_t> leaf_indices(positions.size());
+    level.find_leaf_indices(positions, leaf_indices);
+
+    for(std::size_t i = 0; i < entities.size(); ++i) {
+        registry.emplace<CurrentLeaf>(entities[i], leaf_indices[i]);
     }
+
+    stats.lookups += entities.size();
+    stats.placements += entities.size();
+}
+
+CurrentLeafStats CurrentLeaf::stats(const Level& level)
+{
+    if(const auto stats = level.registry().ctx().find<CurrentLeafStats>()) {
+        return *stats;
+    }
+
+    return CurrentLeafStats();
+}
+
+void CurrentLeaf::reset_stats(Level& level)
+{
+    level.registry().ctx().erase<CurrentLeafStats>();
 }
 
 CurrentLeaf::CurrentLeaf(std::int32_t leaf_index) : m_leaf_index(leaf_index)
@@ -4,12 +4,33 @@
 
 class Level;
 
+struct CurrentLeafStats final {
+    std::uint64_t lookups { 0 };        ///< Entities processed by fixed_update
+    std::uint64_t placements { 0 };     ///< Entities that didn't have a leaf yet
+    std::uint64_t clearance_hits { 0 }; ///< Entities that haven't moved far enough to leave their leaf
+    std::uint64_t hint_hits { 0 };      ///< Entities found in their previous leaf by walking up the tree
+    std::uint64_t leaf_changes { 0 };   ///< Entities that moved to another leaf
+};
+
 class CurrentLeaf final {
 public:
     static void register_component(void);
 
+    /// Update leaves of entities that have a transform; the
+    /// component is only patched when the leaf actually changes
+    /// @param level Level the entities live in
     static void fixed_update(Level& level);
 
+    /// Lookup counters of a level; they are kept in the context of
+    /// the level's registry, so they start over whenever it's loaded
+    /// @param level Level the entities live in
+    /// @return Counters since the level was loaded or the last reset_stats
+    static CurrentLeafStats stats(const Level& level);
+
+    /// Zero the lookup counters of a level
+    /// @param level Level the entities live in
+    static void reset_stats(Level& level);
+
     explicit CurrentLeaf(std::int32_t leaf_index);
 
     constexpr operator std::int32_t(void) const noexcept;
@@ -17,6 +38,12 @@ public:
 
 private:
     std::int32_t m_leaf_index;
+
+    /// Position the leaf was last looked up at and how far the
+    /// entity can move from it without leaving the leaf; these are
+    /// not serialized and a zero clearance forces the next lookup
+    Eigen::Vector3f m_anchor { Eigen::Vector3f::Zero() };
+    float m_clearance { 0.0f };
 };
 
 constexpr CurrentLeaf::operator std::int32_t(void) const noexcept
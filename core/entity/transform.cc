@@ -2,7 +2,11 @@
 
 #include "core/entity/transform.hh"
 
+#include "core/buffer.hh"
 #include "core/components.hh"
+#include "core/exceptions.hh"
+
+constexpr static std::size_t TRANSFORM_FLOATS = 12;
 
 static JSON_Value* serialize_transform(const entt::registry& registry, entt::entity entity)
 {
@@ -88,9 +92,61 @@ static void deserialize_transform(entt::registry& registry, entt::entity entity,
     registry.emplace_or_replace<Transform>(entity, affine);
 }
 
+static void encode_transforms(const entt::registry& registry, std::span<const entt::entity> entities, WriteBuffer& buffer)
+{
+    std::vector<float> values;
+    values.reserve(entities.size() * TRANSFORM_FLOATS);
+
+    for(auto entity : entities) {
+        const auto& affine = registry.get<Transform>(entity).affine();
+
+        for(int i = 0; i < 3; ++i) {
+            values.push_back(affine.linear()(0, i));
+            values.push_back(affine.linear()(1, i));
+            values.push_back(affine.linear()(2, i));
+        }
+
+        values.push_back(affine.translation().x());
+        values.push_back(affine.translation().y());
+        values.push_back(affine.translation().z());
+    }
+
+    buffer.write_span<float>(values);
+}
+
+static void decode_transforms(entt::registry& registry, std::span<const entt::entity> entities, ReadBuffer& buffer)
+{
+    auto floatcnt = entities.size() * TRANSFORM_FLOATS;
+
+    qf::throw_if<std::runtime_error>(floatcnt * sizeof(float) > buffer.remaining(), "unexpected end-of-file");
+
+    std::vector<float> values(floatcnt);
+    buffer.read_span<float>(values);
+
+    std::vector<Transform> transforms;
+    transforms.reserve(entities.size());
+
+    for(std::size_t i = 0; i < entities.size(); ++i) {
+        auto source = &values[i * TRANSFORM_FLOATS];
+
+        Eigen::Affine3f affine(Eigen::Affine3f::Identity());
+        affine.linear().col(0) = Eigen::Vector3f(source[0], source[1], source[2]);
+        affine.linear().col(1) = Eigen::Vector3f(source[3], source[4], source[5]);
+        affine.linear().col(2) = Eigen::Vector3f(source[6], source[7], source[8]);
+        affine.translation() = Eigen::Vector3f(source[9], source[10], source[11]);
+
+        qf::throw_if_not<std::runtime_error>(affine.matrix().allFinite(), "invalid transform");
+
+        transforms.emplace_back(affine);
+    }
+
+    registry.insert<Transform>(entities.begin(), entities.end(), transforms.cbegin());
+}
+
 void Transform::register_component(void)
 {
-    components::register_component("transform", &serialize_transform, &deserialize_transform);
+    components::register_component("transform", entt::type_hash<Transform>::value(), &serialize_transform, &deserialize_transform,
+        &encode_transforms, &decode_transforms);
 }
 
 Transform::Transform(const Eigen::Affine3f& affine) noexcept : m_affine(affine)
@@ -22,6 +22,18 @@ static int stbi_physfs_eof(void* context)
 }
 
 static const void* image_load_fn(const char* name, std::uint32_t flags)
+{
+    return Image::decode(name, flags);
+}
+
+static void image_free_fn(const void* resource)
+{
+    assert(resource);
+
+    Image::release(reinterpret_cast<const Image*>(resource));
+}
+
+const Image* Image::decode(const char* name, std::uint32_t flags)
 {
     assert(name);
 
@@ -30,7 +42,9 @@ static const void* image_load_fn(const char* name, std::uint32_t flags)
     callbacks.skip = &stbi_physfs_skip;
     callbacks.eof = &stbi_physfs_eof;
 
-    stbi_set_flip_vertically_on_load(bool(flags & RESFLAG_IMG_FLIP));
+    // The flag is per-thread since images
+    // can be decoded on several threads at once
+    stbi_set_flip_vertically_on_load_thread(bool(flags & RESFLAG_IMG_FLIP));
 
     auto file = PHYSFS_openRead(name);
 
@@ -53,6 +67,8 @@ static const void* image_load_fn(const char* name, std::uint32_t flags)
     int channels;
     auto pixels = stbi_load_from_callbacks(&callbacks, file, &width, &height, &channels, desired_channels);
 
+    PHYSFS_close(file);
+
     if(pixels == nullptr) {
         LOG_WARNING("{}: {}", name, stbi_failure_reason());
         return nullptr;
@@ -67,11 +83,10 @@ static const void* image_load_fn(const char* name, std::uint32_t flags)
     return image;
 }
 
-static void image_free_fn(const void* resource)
+void Image::release(const Image* image)
 {
-    assert(resource);
+    assert(image);
 
-    auto image = reinterpret_cast<const Image*>(resource);
     stbi_image_free(image->pixels);
 
     delete image;
@@ -8,6 +8,17 @@ constexpr static std::uint32_t RESFLAG_IMG_GRAY = 1 << 9; ///< If set, the pixel
 struct Image final {
     static void register_resource(void);
 
+    /// Decode an image file bypassing the resource system;
+    /// this is safe to call from any thread at any time
+    /// @param name Image file path
+    /// @param flags RESFLAG_IMG_* flags
+    /// @return Decoded image or nullptr on failure, must be freed with Image::release
+    static const Image* decode(const char* name, std::uint32_t flags);
+
+    /// Free an image returned by Image::decode
+    /// @param image Image to free
+    static void release(const Image* image);
+
     int width;
     int height;
     int channels;
@@ -0,0 +1,339 @@
+#include "core/pch.hh"
+
+#include "core/jobs.hh"
+
+#include "core/cmdline.hh"
+#include "core/exceptions.hh"
+
+/// Amount of chunks parallel_for makes per pool thread; more
+/// chunks than threads keep threads busy when chunks are uneven
+constexpr static std::size_t CHUNKS_PER_THREAD = 4;
+
+struct Job final {
+    jobs::job_func function;
+    jobs::Counter* counter;
+};
+
+struct JobQueue final {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+/// Queue 0 belongs to the main thread and
+/// the rest of them to worker threads in order
+static std::vector<std::unique_ptr<JobQueue>> s_queues;
+static std::vector<std::thread> s_threads;
+
+static std::atomic<std::size_t> s_pending_jobs;
+static std::atomic<std::size_t> s_next_queue;
+static std::atomic<unsigned int> s_sleeping_threads;
+static std::atomic_bool s_is_stopping;
+
+static std::mutex s_sleep_mutex;
+static std::condition_variable s_sleep_condition;
+
+static thread_local std::size_t s_queue_index = SIZE_MAX;
+
+static void run_job(Job& job) noexcept
+{
+    job.function();
+
+    if(job.counter) {
+        job.counter->decrement();
+    }
+}
+
+static bool pop_job(std::size_t queue_index, Job& out_job)
+{
+    auto& queue = *s_queues[queue_index];
+
+    std::scoped_lock lock(queue.mutex);
+
+    if(queue.jobs.empty()) {
+        return false;
+    }
+
+    out_job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+static bool steal_job(std::size_t queue_index, Job& out_job)
+{
+    auto& queue = *s_queues[queue_index];
+
+    std::unique_lock lock(queue.mutex, std::try_to_lock);
+
+    if(!lock.owns_lock() || queue.jobs.empty()) {
+        return false;
+    }
+
+    out_job = std::move(queue.jobs.front());
+    queue.jobs.pop_front();
+    return true;
+}
+
+/// Take a job from the own queue of the calling thread
+/// or steal one from another queue, starting with the
+/// next one so that threads don't all pick the same victim
+static bool take_job(Job& out_job)
+{
+    auto queue_count = s_queues.size();
+    auto own_index = (s_queue_index < queue_count) ? s_queue_index : 0;
+
+    if(s_queue_index < queue_count && pop_job(own_index, out_job)) {
+        s_pending_jobs.fetch_sub(1);
+        return true;
+    }
+
+    for(std::size_t i = 1; i <= queue_count; ++i) {
+        if(steal_job((own_index + i) % queue_count, out_job)) {
+            s_pending_jobs.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void worker_main(std::size_t queue_index)
+{
+    s_queue_index = queue_index;
+
+    Job job;
+
+    while(true) {
+        if(take_job(job)) {
+            run_job(job);
+            continue;
+        }
+
+        std::unique_lock lock(s_sleep_mutex);
+
+        if(s_is_stopping.load() && s_pending_jobs.load() == 0) {
+            break;
+        }
+
+        s_sleeping_threads.fetch_add(1);
+
+        s_sleep_condition.wait(lock, [] {
+            return s_pending_jobs.load() > 0 || s_is_stopping.load();
+        });
+
+        s_sleeping_threads.fetch_sub(1);
+    }
+}
+
+void jobs::Counter::increment(std::size_t amount) noexcept
+{
+    m_value.fetch_add(amount);
+}
+
+void jobs::Counter::decrement(void) noexcept
+{
+    [[maybe_unused]] auto previous = m_value.fetch_sub(1);
+    assert(previous > 0);
+
+    if(previous == 1 && s_sleeping_threads.load() > 0) {
+        // Somebody might be waiting for this very counter;
+        // taking the lock makes sure they either see it done
+        // before going to sleep or get the notification
+        std::scoped_lock lock(s_sleep_mutex);
+        s_sleep_condition.notify_all();
+    }
+}
+
+bool jobs::Counter::is_done(void) const noexcept
+{
+    return m_value.load() == 0;
+}
+
+void jobs::init(unsigned int worker_count)
+{
+    qf::throw_if_not<std::logic_error>(s_queues.empty(), "job system is already initialized");
+
+    s_pending_jobs.store(0);
+    s_next_queue.store(0);
+    s_sleeping_threads.store(0);
+    s_is_stopping.store(false);
+
+    for(unsigned int i = 0; i <= worker_count; ++i) {
+        s_queues.push_back(std::make_unique<JobQueue>());
+    }
+
+    s_queue_index = 0;
+
+    for(unsigned int i = 1; i <= worker_count; ++i) {
+        s_threads.emplace_back(&worker_main, static_cast<std::size_t>(i));
+    }
+
+    LOG_INFO("job system: {} worker threads", worker_count);
+}
+
+void jobs::init(void)
+{
+    if(auto value = cmdline::value_or_cstr("jobs", nullptr)) {
+        // Pinning the worker count makes it possible
+        // to compare timings between different machines
+        jobs::init(static_cast<unsigned int>(std::strtoul(value, nullptr, 10)));
+        return;
+    }
+
+    auto hardware_threads = std::thread::hardware_concurrency();
+    jobs::init((hardware_threads > 1) ? hardware_threads - 1 : 0);
+}
+
+void jobs::deinit(void)
+{
+    if(s_queues.empty()) {
+        return;
+    }
+
+    // Workers drain the queues before they leave; the
+    // main thread helps in case there are no workers at all
+    Job job;
+
+    while(take_job(job)) {
+        run_job(job);
+    }
+
+    {
+        std::scoped_lock lock(s_sleep_mutex);
+        s_is_stopping.store(true);
+    }
+
+    s_sleep_condition.notify_all();
+
+    for(auto& thread : s_threads) {
+        thread.join();
+    }
+
+    s_threads.clear();
+    s_queues.clear();
+
+    s_queue_index = SIZE_MAX;
+}
+
+jobs::DeinitGuard::~DeinitGuard(void)
+{
+    jobs::deinit();
+}
+
+unsigned int jobs::thread_count(void) noexcept
+{
+    return static_cast<unsigned int>(std::max<std::size_t>(s_queues.size(), 1));
+}
+
+void jobs::submit(job_func job, Counter* counter)
+{
+    if(counter) {
+        counter->increment();
+    }
+
+    if(s_queues.size() <= 1) {
+        // Without workers there's nobody to hand
+        // the job over to, so it's done right away
+        Job inline_job { std::move(job), counter };
+        run_job(inline_job);
+        return;
+    }
+
+    auto queue_index = s_queue_index;
+
+    if(queue_index >= s_queues.size()) {
+        queue_index = s_next_queue.fetch_add(1) % s_queues.size();
+    }
+
+    {
+        auto& queue = *s_queues[queue_index];
+        std::scoped_lock lock(queue.mutex);
+        queue.jobs.push_back(Job { std::move(job), counter });
+    }
+
+    s_pending_jobs.fetch_add(1);
+
+    if(s_sleeping_threads.load() > 0) {
+        // Taking the lock makes sure a thread that is about to
+        // sleep either sees the new job or gets the notification
+        std::scoped_lock lock(s_sleep_mutex);
+        s_sleep_condition.notify_one();
+    }
+}
+
+void jobs::wait(Counter& counter)
+{
+    Job job;
+
+    while(!counter.is_done()) {
+        if(s_queues.size() > 1 && take_job(job)) {
+            run_job(job);
+            continue;
+        }
+
+        // Nothing to help with, so the jobs that are left
+        // are all being run by other threads; sleep until either
+        // the counter drops to zero or there's new work to steal
+        std::unique_lock lock(s_sleep_mutex);
+
+        s_sleeping_threads.fetch_add(1);
+
+        s_sleep_condition.wait(lock, [&counter] {
+            return counter.is_done() || s_pending_jobs.load() > 0;
+        });
+
+        s_sleeping_threads.fetch_sub(1);
+    }
+}
+
+void jobs::parallel_for(std::size_t count, std::size_t grain, const range_func& fn)
+{
+    if(count == 0) {
+        return;
+    }
+
+    grain = std::max<std::size_t>(grain, 1);
+
+    auto max_chunks = static_cast<std::size_t>(thread_count()) * CHUNKS_PER_THREAD;
+    auto chunk_count = std::min((count + grain - 1) / grain, max_chunks);
+
+    if(chunk_count <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    auto chunk_size = (count + chunk_count - 1) / chunk_count;
+
+    Counter counter;
+    std::mutex exception_mutex;
+    std::exception_ptr exception;
+
+    auto run_chunk = [&fn, &exception_mutex, &exception](std::size_t begin, std::size_t end) {
+        try {
+            fn(begin, end);
+        }
+        catch(...) {
+            std::scoped_lock lock(exception_mutex);
+
+            if(!exception) {
+                exception = std::current_exception();
+            }
+        }
+    };
+
+    // The first chunk is left for the calling thread
+    for(auto begin = chunk_size; begin < count; begin += chunk_size) {
+        auto end = std::min(begin + chunk_size, count);
+
+        submit([&run_chunk, begin, end] {
+            run_chunk(begin, end);
+        }, &counter);
+    }
+
+    run_chunk(0, std::min(chunk_size, count));
+
+    wait(counter);
+
+    if(exception) {
+        std::rethrow_exception(exception);
+    }
+}
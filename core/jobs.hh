@@ -0,0 +1,87 @@
+#ifndef CORE_JOBS_HH
+#define CORE_JOBS_HH
+#pragma once
+
+namespace jobs
+{
+using job_func = std::function<void(void)>;
+using range_func = std::function<void(std::size_t begin, std::size_t end)>;
+} // namespace jobs
+
+namespace jobs
+{
+/// Amount of submitted jobs that are yet to finish; jobs
+/// depending on other jobs wait for their counter, which
+/// runs other pending jobs in the meantime
+class Counter final {
+public:
+    Counter(void) = default;
+    Counter(const Counter& other) = delete;
+    Counter& operator=(const Counter& other) = delete;
+
+    void increment(std::size_t amount = 1) noexcept;
+    void decrement(void) noexcept;
+    bool is_done(void) const noexcept;
+
+private:
+    std::atomic<std::size_t> m_value { 0 };
+};
+} // namespace jobs
+
+namespace jobs
+{
+/// Start worker threads; the calling thread becomes the main
+/// thread of the pool and helps out whenever it waits for jobs
+/// @param worker_count Amount of worker threads, zero runs every job right away on the submitting thread
+void init(unsigned int worker_count);
+
+/// Start a worker thread for every hardware thread but one
+/// or as many as the "jobs" command line option asks for
+void init(void);
+
+/// Finish every pending job and stop worker threads;
+/// does nothing when the job system isn't running
+void deinit(void);
+
+/// Amount of threads that run jobs, including the main thread
+unsigned int thread_count(void) noexcept;
+} // namespace jobs
+
+namespace jobs
+{
+/// Calls deinit() when it goes out of scope, so worker threads
+/// are joined even when an exception unwinds past init(); joinable
+/// threads left in the pool would call std::terminate on exit
+class DeinitGuard final {
+public:
+    DeinitGuard(void) = default;
+    DeinitGuard(const DeinitGuard& other) = delete;
+    DeinitGuard& operator=(const DeinitGuard& other) = delete;
+    ~DeinitGuard(void);
+};
+} // namespace jobs
+
+namespace jobs
+{
+/// Queue a job; jobs submitted from a pool thread go to that
+/// thread's own queue and are taken last in, first out, while
+/// idle threads steal the oldest jobs from other queues
+/// @param job Job to run, must not throw
+/// @param counter Counter to bump until the job is done or nullptr
+void submit(job_func job, Counter* counter = nullptr);
+
+/// Run pending jobs until a counter drops to zero; the
+/// calling thread sleeps while there is nothing left to run
+/// @param counter Counter to wait for
+void wait(Counter& counter);
+
+/// Split an index range into chunks and run them in parallel;
+/// the calling thread takes part and returns once every chunk
+/// is done, re-throwing the first exception a chunk has thrown
+/// @param count Amount of indices, the range is [0, count)
+/// @param grain Smallest amount of indices worth a separate job
+/// @param fn Function to run for every chunk
+void parallel_for(std::size_t count, std::size_t grain, const range_func& fn);
+} // namespace jobs
+
+#endif
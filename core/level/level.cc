@@ -5,7 +5,13 @@
 #include "core/buffer.hh"
 #include "core/components.hh"
 #include "core/exceptions.hh"
+#include "core/jobs.hh"
+#include "core/level/pvs.hh"
 #include "core/level/vertex.hh"
+#include "core/mapped_file.hh"
+#include "core/math/frustum.hh"
+#include "core/math/plane.hh"
+#include "core/utils/bitset.hh"
 #include "core/utils/physfs.hh"
 #include "core/utils/string.hh"
 
@@ -14,14 +20,141 @@ constexpr static std::uint8_t MAGIC_BYTE_1 = 'F';
 constexpr static std::uint8_t MAGIC_BYTE_2 = 'L';
 constexpr static std::uint8_t MAGIC_BYTE_3 = 'V';
 
-constexpr static std::uint32_t QFLV_VERSION = 1;
+constexpr static std::uint32_t QFLV_VERSION_1 = 1; ///< Flat sequence of [type][payload] records
+constexpr static std::uint32_t QFLV_VERSION_2 = 2; ///< Lump directory followed by lump payloads
+constexpr static std::uint32_t QFLV_VERSION = QFLV_VERSION_2;
+
+constexpr static std::size_t QFLV_HEADER_SIZE = 12;   ///< Signature, version and lump count
+constexpr static std::size_t QFLV_LUMPINFO_SIZE = 16; ///< Type, offset, size and flags
+constexpr static std::size_t QFLV_TRAILER_SIZE = 4;   ///< Inverted signature
+
+/// Lumps smaller than this are not worth the trouble
+/// of being handed over to a worker thread for decoding
+constexpr static std::size_t QFLV_ASYNC_LUMP_SIZE = 64 * 1024;
+
+constexpr static std::uint32_t LUMPFLAG_RENDER = 1 << 0; ///< Lump is only needed for rendering
 
 constexpr static std::uint32_t LUMP_BSP = 1; ///< Geometry nodes
-constexpr static std::uint32_t LUMP_PVS = 2; ///< Potentially visible set
+constexpr static std::uint32_t LUMP_PVS = 2; ///< Uncompressed potentially visible set (legacy)
 constexpr static std::uint32_t LUMP_MAT = 3; ///< Materials string table
 constexpr static std::uint32_t LUMP_ENT = 4; ///< Entity data as a JSON string
 constexpr static std::uint32_t LUMP_RAD = 5; ///< Lightmaps
 constexpr static std::uint32_t LUMP_VTX = 6; ///< Vertex and index buffer
+constexpr static std::uint32_t LUMP_VIS = 7; ///< Compressed potentially visible set
+constexpr static std::uint32_t LUMP_ECS = 8; ///< Entity data as binary component columns
+constexpr static std::uint32_t LUMP_PVX = 9; ///< Index buffer and packed vertex buffer
+constexpr static std::uint32_t LUMP_BOX = 10; ///< Leaf bounding boxes
+constexpr static std::uint32_t LUMP_BRS = 11; ///< Collision brushes
+constexpr static std::uint32_t LUMP_BSD = 12; ///< Collision brush sides
+constexpr static std::uint32_t LUMP_PAS = 13; ///< Compressed potentially audible set
+constexpr static std::uint32_t LUMP_CLS = 14; ///< Leaf visibility clusters
+
+constexpr static std::size_t BSP_VALUES_PER_NODE = 10;
+constexpr static std::size_t VTX_FLOATS_PER_VERTEX = 14;
+constexpr static std::size_t PVX_VALUES_PER_VERTEX = sizeof(PackedLevelVertex) / sizeof(std::uint16_t);
+constexpr static std::size_t PVX_FLOATS_PER_CHUNK = 6;
+constexpr static std::size_t BOX_FLOATS_PER_LEAF = 6;
+constexpr static std::size_t BRS_VALUES_PER_BRUSH = 9;
+constexpr static std::size_t BSD_FLOATS_PER_SIDE = 4;
+
+/// Distance traces keep from the planes they hit; without it
+/// a trace starting at the end of the previous one would
+/// often begin in solid space due to rounding errors
+constexpr static float TRACE_EPSILON = 1.0f / 32.0f;
+
+/// Amount of viewer leaves whose visible sets are kept around;
+/// a server needs one per distinct leaf its clients are in
+constexpr static std::size_t VIS_SET_CACHE_SIZE = 64;
+
+/// Amount of points find_leaf_indices walks down the tree at once;
+/// interleaving descents hides the latency of fetching nodes
+constexpr static std::size_t FIND_LEAF_PACKET = 16;
+using FindLeafPacket = Eigen::Array<float, FIND_LEAF_PACKET, 1>;
+
+/// Smallest amount of points or rays batched queries hand
+/// over to another thread; smaller batches aren't worth the
+/// overhead of going through the job system
+constexpr static std::size_t FIND_LEAF_JOB_GRAIN = 64 * FIND_LEAF_PACKET;
+constexpr static std::size_t TRACE_RAYS_JOB_GRAIN = 256;
+
+struct LumpInfo final {
+    std::uint32_t type;
+    std::uint32_t offset;
+    std::uint32_t size;
+    std::uint32_t flags;
+};
+
+static std::uint32_t load_u32be(const std::byte* bytes) noexcept
+{
+    auto result = UINT32_C(0x00000000);
+    result |= static_cast<std::uint32_t>(bytes[0]) << 24;
+    result |= static_cast<std::uint32_t>(bytes[1]) << 16;
+    result |= static_cast<std::uint32_t>(bytes[2]) << 8;
+    result |= static_cast<std::uint32_t>(bytes[3]) << 0;
+    return result;
+}
+
+static void read_compressed_rows(ReadBuffer& buffer, std::size_t leafcnt, LevelPVS& out_rows)
+{
+    auto datasize = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+
+    qf::throw_if<std::runtime_error>(leafcnt * sizeof(std::uint32_t) + datasize > buffer.remaining(), "unexpected end-of-file");
+
+    std::vector<std::uint32_t> offsets(leafcnt);
+    buffer.read_span<std::uint32_t>(offsets);
+
+    auto data_bytes = buffer.read_view(datasize);
+
+    auto data_ptr = reinterpret_cast<const std::uint8_t*>(data_bytes.data());
+    std::vector<std::uint8_t> data(data_ptr, data_ptr + datasize);
+
+    out_rows.set_data(leafcnt, std::move(data), std::move(offsets));
+}
+
+static void write_compressed_rows(WriteBuffer& buffer, const LevelPVS& rows)
+{
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(rows.size()));
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(rows.data().size()));
+
+    buffer.write_span<std::uint32_t>(rows.offsets());
+
+    buffer.write(rows.data().data(), rows.data().size());
+}
+
+/// Shrink a box to the part of it that is in front of a plane;
+/// every axis is bounded by how far the others can reach, so the
+/// result is exact for axial planes and conservative otherwise
+static Eigen::AlignedBox3f clip_box_to_plane(const Eigen::AlignedBox3f& box, const Eigen::Vector3f& normal, float offset)
+{
+    if(box.isEmpty()) {
+        return box;
+    }
+
+    Eigen::Vector3f reach = normal.cwiseProduct(box.min()).cwiseMax(normal.cwiseProduct(box.max()));
+    Eigen::AlignedBox3f clipped(box);
+
+    for(int axis = 0; axis < 3; ++axis) {
+        if(normal[axis] == 0.0f) {
+            continue;
+        }
+
+        auto others = reach.sum() - reach[axis];
+        auto limit = -(offset + others) / normal[axis];
+
+        if(normal[axis] > 0.0f) {
+            clipped.min()[axis] = std::max(clipped.min()[axis], limit);
+        }
+        else {
+            clipped.max()[axis] = std::min(clipped.max()[axis], limit);
+        }
+    }
+
+    if((clipped.min().array() > clipped.max().array()).any()) {
+        clipped.setEmpty();
+    }
+
+    return clipped;
+}
 
 void Level::set_geometry(std::vector<std::uint32_t> new_indices, std::vector<LevelVertex> new_vertices) noexcept
 {
@@ -29,10 +162,319 @@ void Level::set_geometry(std::vector<std::uint32_t> new_indices, std::vector<Lev
     m_vertices = std::move(new_vertices);
 }
 
-void Level::set_nodes(std::vector<Node> new_nodes, std::int32_t new_root) noexcept
+Eigen::Hyperplane<float, 3> Level::plane(std::size_t node_index) const noexcept
+{
+    assert(node_index < m_nodes.size());
+
+    Eigen::Vector3f normal(m_plane_x[node_index], m_plane_y[node_index], m_plane_z[node_index]);
+    return Eigen::Hyperplane<float, 3>(normal, m_plane_d[node_index]);
+}
+
+void Level::set_nodes(const std::vector<Node>& new_nodes, std::int32_t new_root)
+{
+    qf::throw_if<std::runtime_error>(new_root < 0 || static_cast<std::size_t>(new_root) >= new_nodes.size(), "invalid root node index");
+
+    std::vector<FlatNode> nodes;
+    std::vector<float> plane_x;
+    std::vector<float> plane_y;
+    std::vector<float> plane_z;
+    std::vector<float> plane_d;
+    std::vector<Leaf> leaves;
+    std::vector<std::uint32_t> leaf_records;
+    std::vector<std::int32_t> record_leaves(new_nodes.size(), -1);
+
+    for(std::size_t i = 0; i < new_nodes.size(); ++i) {
+        if(const auto leaf = std::get_if<Leaf>(&new_nodes[i])) {
+            record_leaves[i] = static_cast<std::int32_t>(leaves.size());
+            leaf_records.push_back(static_cast<std::uint32_t>(i));
+            leaves.push_back(*leaf);
+        }
+    }
+
+    auto root_node = LEVEL_CHILD_NONE;
+
+    if(record_leaves[new_root] >= 0) {
+        root_node = ~record_leaves[new_root];
+    }
+    else {
+        struct PendingNode final {
+            std::int32_t record;
+            std::int32_t parent;
+            std::int32_t slot;
+        };
+
+        std::vector<bool> visited(new_nodes.size(), false);
+        std::vector<PendingNode> stack;
+
+        stack.push_back(PendingNode { new_root, -1, 0 });
+
+        // Pre-order depth-first walk; the back child is pushed
+        // first so that the front child ends up right after its parent
+        while(!stack.empty()) {
+            auto pending = stack.back();
+            stack.pop_back();
+
+            qf::throw_if_fmt<std::runtime_error>(visited[pending.record], "node {} is referenced more than once", pending.record);
+            visited[pending.record] = true;
+
+            const auto& internal = std::get<Internal>(new_nodes[pending.record]);
+            auto node_index = static_cast<std::int32_t>(nodes.size());
+
+            if(pending.parent >= 0) {
+                nodes[pending.parent].children[pending.slot] = node_index;
+            }
+            else {
+                root_node = node_index;
+            }
+
+            FlatNode node;
+            node.children[0] = LEVEL_CHILD_NONE;
+            node.children[1] = LEVEL_CHILD_NONE;
+            node.parent = pending.parent;
+            node.plane_type = math::plane_type(internal.plane.normal());
+            node.plane_signbits = math::plane_signbits(internal.plane.normal());
+
+            nodes.push_back(node);
+            plane_x.push_back(internal.plane.coeffs()[0]);
+            plane_y.push_back(internal.plane.coeffs()[1]);
+            plane_z.push_back(internal.plane.coeffs()[2]);
+            plane_d.push_back(internal.plane.coeffs()[3]);
+
+            for(auto slot : { 1, 0 }) {
+                auto child = (slot == 0) ? internal.front : internal.back;
+
+                if(child < 0) {
+                    continue;
+                }
+
+                qf::throw_if_fmt<std::runtime_error>(static_cast<std::size_t>(child) >= new_nodes.size(), "invalid child node index {}",
+                    child);
+
+                if(record_leaves[child] >= 0) {
+                    nodes[node_index].children[slot] = ~record_leaves[child];
+                }
+                else {
+                    stack.push_back(PendingNode { child, node_index, slot });
+                }
+            }
+        }
+    }
+
+    std::vector<std::int32_t> leaf_parents(leaves.size(), -1);
+
+    for(std::size_t i = 0; i < nodes.size(); ++i) {
+        for(auto child : nodes[i].children) {
+            if(child < 0 && child != LEVEL_CHILD_NONE) {
+                leaf_parents[~child] = static_cast<std::int32_t>(i);
+            }
+        }
+    }
+
+    m_nodes = std::move(nodes);
+    m_plane_x = std::move(plane_x);
+    m_plane_y = std::move(plane_y);
+    m_plane_z = std::move(plane_z);
+    m_plane_d = std::move(plane_d);
+    m_leaves = std::move(leaves);
+    m_leaf_parents = std::move(leaf_parents);
+    m_leaf_records = std::move(leaf_records);
+    m_record_count = new_nodes.size();
+    m_root_node = root_node;
+
+    m_wide_tree.build(*this);
+
+    update_clusters();
+
+    m_node_bounds.clear();
+    m_brush_list_offsets.clear();
+    m_brush_lists.clear();
+
+    invalidate_vis_sets();
+}
+
+void Level::update_bounds(void)
+{
+    Eigen::AlignedBox3f world;
+    world.setEmpty();
+
+    if(m_root_node == LEVEL_CHILD_NONE) {
+        // Nothing to bound
+    }
+    else if(m_indices.size() && m_vertices.size()) {
+        for(const auto& vertex : m_vertices) {
+            world.extend(vertex.position);
+        }
+    }
+    else if(m_leaf_bounds.size() == m_leaves.size()) {
+        // Without geometry the world is as big as
+        // the leaf bounds the level was saved with
+        for(const auto& bounds : m_leaf_bounds) {
+            world.extend(bounds);
+        }
+    }
+    else if(m_leaf_bounds.size()) {
+        LOG_WARNING("bounds count ({}) doesn't match the leaf count ({}), ignoring bounds", m_leaf_bounds.size(), m_leaves.size());
+    }
+
+    if(world.isEmpty()) {
+        m_leaf_bounds.clear();
+        m_node_bounds.clear();
+        return;
+    }
+
+    // Leaf bounds are the part of the world the tree carves out
+    // for a leaf rather than the extent of its faces; a leaf with
+    // no faces or an entity standing above a floor face is still
+    // inside of them, so neither is culled when it's in view
+    Eigen::AlignedBox3f empty;
+    empty.setEmpty();
+
+    std::vector<Eigen::AlignedBox3f> leaf_bounds(m_leaves.size(), empty);
+    std::vector<Eigen::AlignedBox3f> node_volumes(m_nodes.size(), empty);
+
+    if(m_root_node < 0) {
+        leaf_bounds[~m_root_node] = world;
+    }
+    else {
+        node_volumes[m_root_node] = world;
+    }
+
+    // Parents come before their children in the depth-first
+    // layout, so a node's volume is known by the time it's split
+    for(std::size_t i = 0; i < m_nodes.size(); ++i) {
+        Eigen::Vector3f normal(m_plane_x[i], m_plane_y[i], m_plane_z[i]);
+
+        for(int side = 0; side < 2; ++side) {
+            auto child = m_nodes[i].children[side];
+
+            if(child == LEVEL_CHILD_NONE) {
+                continue;
+            }
+
+            auto volume = (side == 0) ? clip_box_to_plane(node_volumes[i], normal, m_plane_d[i])
+                                      : clip_box_to_plane(node_volumes[i], -normal, -m_plane_d[i]);
+
+            if(child >= 0) {
+                node_volumes[child].extend(volume);
+            }
+            else {
+                leaf_bounds[~child].extend(volume);
+            }
+        }
+    }
+
+    m_leaf_bounds = std::move(leaf_bounds);
+
+    m_node_bounds.resize(m_nodes.size());
+
+    // Nodes are laid out depth-first so children always
+    // come after their parent; going backwards visits them first
+    for(auto i = m_nodes.size(); i-- > 0;) {
+        m_node_bounds[i].setEmpty();
+
+        for(auto child : m_nodes[i].children) {
+            if(child >= 0) {
+                m_node_bounds[i].extend(m_node_bounds[child]);
+            }
+            else if(child != LEVEL_CHILD_NONE) {
+                m_node_bounds[i].extend(m_leaf_bounds[~child]);
+            }
+        }
+    }
+}
+
+void Level::build_clusters(void)
+{
+    if(m_pvs.size() == 0 || m_pvs.size() != m_cluster_count) {
+        return;
+    }
+
+    auto count = m_cluster_count;
+    auto row_words = m_pvs.row_words();
+
+    std::vector<std::uint64_t> rows(count * row_words);
+    std::vector<std::int32_t> merged_clusters(count);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        m_pvs.decompress_row(i, std::span(rows).subspan(i * row_words, row_words));
+        merged_clusters[i] = static_cast<std::int32_t>(i);
+    }
+
+    // Merging clusters merges PVS columns as well, which can make
+    // rows that used to differ identical; hence the repetition
+    while(true) {
+        auto row_less = [&rows, row_words](std::int32_t a, std::int32_t b) {
+            auto row_a = rows.cbegin() + a * row_words;
+            auto row_b = rows.cbegin() + b * row_words;
+            return std::lexicographical_compare(row_a, row_a + row_words, row_b, row_b + row_words);
+        };
+
+        std::vector<std::int32_t> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), row_less);
+
+        std::vector<std::int32_t> new_indices(count);
+        std::vector<std::int32_t> representatives;
+
+        for(std::size_t i = 0; i < count; ++i) {
+            if(i == 0 || row_less(order[i - 1], order[i])) {
+                representatives.push_back(order[i]);
+            }
+
+            new_indices[order[i]] = static_cast<std::int32_t>(representatives.size() - 1);
+        }
+
+        if(representatives.size() == count) {
+            break;
+        }
+
+        auto new_count = representatives.size();
+        auto new_row_words = utils::bitset_words(new_count);
+
+        std::vector<std::uint64_t> new_rows(new_count * new_row_words, UINT64_C(0));
+
+        for(std::size_t i = 0; i < new_count; ++i) {
+            auto old_row = std::span<const std::uint64_t>(rows).subspan(representatives[i] * row_words, row_words);
+            auto new_row = &new_rows[i * new_row_words];
+
+            for(auto cluster : utils::set_bits(old_row)) {
+                auto new_index = new_indices[cluster];
+                new_row[new_index / 64] |= UINT64_C(1) << (new_index % 64);
+            }
+        }
+
+        for(auto& cluster : merged_clusters) {
+            cluster = new_indices[cluster];
+        }
+
+        rows = std::move(new_rows);
+        count = new_count;
+        row_words = new_row_words;
+    }
+
+    if(count == m_cluster_count) {
+        return;
+    }
+
+    for(auto& leaf : m_leaves) {
+        leaf.cluster = merged_clusters[leaf.cluster];
+    }
+
+    update_clusters();
+
+    LevelPVS new_pvs;
+    new_pvs.compress(count, rows);
+    new_pvs.set_cached(m_pvs.is_cached());
+
+    set_pvs(std::move(new_pvs));
+}
+
+void Level::set_brushes(std::vector<Brush> new_brushes, std::vector<BrushSide> new_sides)
 {
-    m_nodes = std::move(new_nodes);
-    m_root_node = new_root;
+    m_brushes = std::move(new_brushes);
+    m_brush_sides = std::move(new_sides);
+
+    link_brushes();
 }
 
 void Level::set_materials(std::vector<std::string> new_materials) noexcept
@@ -40,29 +482,65 @@ void Level::set_materials(std::vector<std::string> new_materials) noexcept
     m_materials = std::move(new_materials);
 }
 
+void Level::set_pvs(LevelPVS new_pvs)
+{
+    m_pvs = std::move(new_pvs);
+
+    build_pas();
+    m_pas.set_cached(m_pvs.is_cached());
+
+    invalidate_vis_sets();
+}
+
 void Level::purge(void) noexcept
 {
-    m_registry.clear();
+    // A fresh registry drops context variables along with
+    // the entities, so per-level state such as CurrentLeaf
+    // stats doesn't carry over into the next level
+    m_registry = entt::registry();
 
     m_nodes.clear();
+    m_plane_x.clear();
+    m_plane_y.clear();
+    m_plane_z.clear();
+    m_plane_d.clear();
+    m_leaves.clear();
+    m_leaf_parents.clear();
+    m_wide_tree.clear();
+    m_node_bounds.clear();
+    m_leaf_bounds.clear();
+    m_cluster_offsets.clear();
+    m_cluster_leaves.clear();
+    m_cluster_records.clear();
+    m_brushes.clear();
+    m_brush_sides.clear();
+    m_brush_list_offsets.clear();
+    m_brush_lists.clear();
+    m_leaf_records.clear();
     m_materials.clear();
     m_pvs.clear();
+    m_pas.clear();
     m_indices.clear();
     m_vertices.clear();
 
-    m_root_node = -1;
+    m_record_count = 0;
+    m_cluster_count = 0;
+    m_root_node = LEVEL_CHILD_NONE;
+
+    invalidate_vis_sets();
 }
 
-void Level::load(std::string_view path)
+void Level::load(std::string_view path, std::uint32_t flags)
 {
     auto path_unfucked = std::string(path);
-    auto file = PHYSFS_openRead(path_unfucked.c_str());
 
-    qf::throw_if_not<std::runtime_error>(file, utils::physfs_error());
+    // The file is mapped into memory as-is and the buffer
+    // only borrows the mapping, so the lump readers decode
+    // straight from the page cache without an intermediate copy
+    MappedFile file(path_unfucked);
 
     ReadBuffer buffer;
-    buffer.reset(file);
-    PHYSFS_close(file);
+    buffer.borrow(file.data(), file.size());
 
     auto magic_0 = buffer.read<std::uint8_t>();
     auto magic_1 = buffer.read<std::uint8_t>();
@@ -75,18 +553,1106 @@ void Level::load(std::string_view path)
     signature_valid = signature_valid && magic_2 == MAGIC_BYTE_2;
     signature_valid = signature_valid && magic_3 == MAGIC_BYTE_3;
 
-    qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
-    qf::throw_if_not<std::runtime_error>(signature_valid, "invalid file signature");
+    qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    qf::throw_if_not<std::runtime_error>(signature_valid, "invalid file signature");
+
+    auto version = buffer.read<std::uint32_t>();
+    auto lumpcnt = buffer.read<std::uint32_t>();
+
+    qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    qf::throw_if_not<std::runtime_error>(version == QFLV_VERSION_1 || version == QFLV_VERSION_2, "unsupported file version");
+    qf::throw_if_not<std::runtime_error>(lumpcnt > 0, "no lumps present");
+
+    purge();
+
+    if(version == QFLV_VERSION_1) {
+        load_sequential(buffer, lumpcnt, flags);
+
+        if(!buffer.is_ended()) {
+            LOG_WARNING("{}: garbage data after expected end-of-file", path_unfucked);
+        }
+    }
+    else {
+        load_directory(buffer, lumpcnt, flags);
+    }
+
+    if(m_cluster_records.size() == m_leaves.size()) {
+        for(std::size_t i = 0; i < m_leaves.size(); ++i) {
+            m_leaves[i].cluster = m_cluster_records[i];
+        }
+
+        update_clusters();
+    }
+    else if(m_cluster_records.size()) {
+        LOG_WARNING("cluster count ({}) doesn't match the leaf count ({}), ignoring clusters", m_cluster_records.size(), m_leaves.size());
+    }
+
+    remap_pvs();
+    update_bounds();
+    link_brushes();
+
+    if(m_pas.size() != m_pvs.size()) {
+        if(m_pas.size()) {
+            LOG_WARNING("PAS size ({}) doesn't match the PVS size ({}), rebuilding PAS", m_pas.size(), m_pvs.size());
+        }
+
+        build_pas();
+    }
+
+    m_leaf_records = std::vector<std::uint32_t>();
+    m_record_count = 0;
+    m_cluster_records = std::vector<std::int32_t>();
+
+    m_pvs.set_cached(!(flags & LEVELFLAG_NO_PVS_CACHE));
+    m_pas.set_cached(!(flags & LEVELFLAG_NO_PVS_CACHE));
+
+    invalidate_vis_sets();
+}
+
+void Level::save(std::string_view path, std::uint32_t flags) const
+{
+    using write_lump_fn = void (Level::*)(WriteBuffer&) const;
+
+    std::vector<std::pair<LumpInfo, write_lump_fn>> pending_lumps;
+
+    auto enqueue_lump = [&pending_lumps](std::uint32_t type, std::uint32_t flags, write_lump_fn write_fn) {
+        LumpInfo info;
+        info.type = type;
+        info.offset = 0;
+        info.size = 0;
+        info.flags = flags;
+
+        pending_lumps.emplace_back(info, write_fn);
+    };
+
+    if(m_root_node != LEVEL_CHILD_NONE) {
+        enqueue_lump(LUMP_BSP, 0, &Level::write_lump_bsp);
+    }
+
+    if(m_leaf_bounds.size() && m_leaf_bounds.size() == m_leaves.size()) {
+        enqueue_lump(LUMP_BOX, 0, &Level::write_lump_box);
+    }
+
+    for(std::size_t i = 0; i < m_leaves.size(); ++i) {
+        if(m_leaves[i].cluster != static_cast<std::int32_t>(i)) {
+            enqueue_lump(LUMP_CLS, 0, &Level::write_lump_cls);
+            break;
+        }
+    }
+
+    if(m_brushes.size()) {
+        enqueue_lump(LUMP_BRS, 0, &Level::write_lump_brs);
+        enqueue_lump(LUMP_BSD, 0, &Level::write_lump_bsd);
+    }
+
+    if(m_pvs.size()) {
+        enqueue_lump(LUMP_VIS, 0, &Level::write_lump_vis);
+    }
+
+    if(m_pas.size() && m_pas.size() == m_pvs.size()) {
+        enqueue_lump(LUMP_PAS, 0, &Level::write_lump_pas);
+    }
+
+    if(m_materials.size()) {
+        enqueue_lump(LUMP_MAT, 0, &Level::write_lump_mat);
+    }
+
+    if(m_registry.view<entt::entity>().size()) {
+        if(flags & SAVEFLAG_JSON_ENTITIES) {
+            enqueue_lump(LUMP_ENT, 0, &Level::write_lump_ent);
+        }
+        else {
+            enqueue_lump(LUMP_ECS, 0, &Level::write_lump_ecs);
+        }
+    }
+
+    if(m_vertices.size() && m_indices.size()) {
+        if(flags & SAVEFLAG_PACKED_VERTICES) {
+            enqueue_lump(LUMP_PVX, LUMPFLAG_RENDER, &Level::write_lump_pvx);
+        }
+        else {
+            enqueue_lump(LUMP_VTX, LUMPFLAG_RENDER, &Level::write_lump_vtx);
+        }
+    }
+
+    auto path_unfucked = std::string(path);
+
+    std::unique_ptr<PHYSFS_File, decltype(&PHYSFS_close)> file(PHYSFS_openWrite(path_unfucked.c_str()), &PHYSFS_close);
+    qf::throw_if_not<std::runtime_error>(file != nullptr, utils::physfs_error());
+
+    auto write_buffer = [&file](const WriteBuffer& buffer) {
+        auto written = PHYSFS_writeBytes(file.get(), buffer.data(), buffer.size());
+        qf::throw_if_not<std::runtime_error>(written == static_cast<PHYSFS_sint64>(buffer.size()), utils::physfs_error());
+    };
+
+    // The directory is written with blanks first; lumps are then
+    // serialized and flushed one at a time, so only a single lump is
+    // ever kept in memory, and the directory is patched at the very end
+    WriteBuffer header;
+
+    header.write<std::uint8_t>(MAGIC_BYTE_0);
+    header.write<std::uint8_t>(MAGIC_BYTE_1);
+    header.write<std::uint8_t>(MAGIC_BYTE_2);
+    header.write<std::uint8_t>(MAGIC_BYTE_3);
+
+    header.write<std::uint32_t>(QFLV_VERSION);
+    header.write<std::uint32_t>(static_cast<std::uint32_t>(pending_lumps.size()));
+
+    for(std::size_t i = 0; i < pending_lumps.size(); ++i) {
+        header.write<std::uint32_t>(0);
+        header.write<std::uint32_t>(0);
+        header.write<std::uint32_t>(0);
+        header.write<std::uint32_t>(0);
+    }
+
+    assert(header.size() == QFLV_HEADER_SIZE + QFLV_LUMPINFO_SIZE * pending_lumps.size());
+
+    write_buffer(header);
+
+    WriteBuffer lump;
+    std::size_t file_size = header.size();
+
+    for(auto& [info, write_fn] : pending_lumps) {
+        lump.reset();
+
+        (this->*write_fn)(lump);
+
+        qf::throw_if<std::runtime_error>(file_size + lump.size() + QFLV_TRAILER_SIZE > UINT32_MAX, "level is too big");
+
+        info.offset = static_cast<std::uint32_t>(file_size);
+        info.size = static_cast<std::uint32_t>(lump.size());
+
+        write_buffer(lump);
+
+        file_size += lump.size();
+    }
+
+    WriteBuffer trailer;
+
+    trailer.write<std::uint8_t>(MAGIC_BYTE_3);
+    trailer.write<std::uint8_t>(MAGIC_BYTE_2);
+    trailer.write<std::uint8_t>(MAGIC_BYTE_1);
+    trailer.write<std::uint8_t>(MAGIC_BYTE_0);
+
+    write_buffer(trailer);
+
+    WriteBuffer directory;
+
+    for(const auto& [info, write_fn] : pending_lumps) {
+        directory.write<std::uint32_t>(info.type);
+        directory.write<std::uint32_t>(info.offset);
+        directory.write<std::uint32_t>(info.size);
+        directory.write<std::uint32_t>(info.flags);
+    }
+
+    qf::throw_if_not<std::runtime_error>(PHYSFS_seek(file.get(), QFLV_HEADER_SIZE), utils::physfs_error());
+
+    write_buffer(directory);
+
+    qf::throw_if_not<std::runtime_error>(PHYSFS_close(file.release()), utils::physfs_error());
+}
+
+bool Level::load_safe(std::string_view path, std::uint32_t flags) noexcept
+{
+    try {
+        load(path, flags);
+        return true;
+    }
+    catch(const std::exception& ex) {
+        LOG_WARNING("{}: load failed: {}", path, ex.what());
+        return false;
+    }
+    catch(...) {
+        LOG_WARNING("{}: load failed", path);
+        return false;
+    }
+}
+
+bool Level::save_safe(std::string_view path, std::uint32_t flags) const noexcept
+{
+    try {
+        save(path, flags);
+        return true;
+    }
+    catch(const std::exception& ex) {
+        LOG_WARNING("{}: save failed: {}", path, ex.what());
+        return false;
+    }
+    catch(...) {
+        LOG_WARNING("{}: save failed", path);
+        return false;
+    }
+}
+
+std::int32_t Level::find_leaf_index(const Eigen::Vector3f& position) const
+{
+    assert(position.allFinite());
+
+    if(!m_wide_tree.empty()) {
+        return m_wide_tree.find_leaf_index(position);
+    }
+
+    auto child = m_root_node;
+
+    while(child >= 0) {
+        child = m_nodes[child].children[(node_distance(child, position) >= 0.0f) ? 0 : 1];
+    }
+
+    return (child == LEVEL_CHILD_NONE) ? -1 : ~child;
+}
+
+std::int32_t Level::find_leaf_index(const Eigen::Vector3f& position, std::int32_t hint_leaf, float& clearance) const
+{
+    assert(position.allFinite());
+
+    // Squared distance to the nearest plane on the path
+    // down to the leaf; dividing by the squared normal length
+    // keeps it right for planes that aren't normalized
+    auto nearest = std::numeric_limits<float>::infinity();
+    auto child = m_root_node;
+
+    auto is_hint_valid = hint_leaf >= 0 && static_cast<std::size_t>(hint_leaf) < m_leaf_parents.size();
+    is_hint_valid = is_hint_valid && (m_leaf_parents[hint_leaf] >= 0 || m_root_node == ~hint_leaf);
+
+    if(is_hint_valid) {
+        auto from = ~hint_leaf;
+        child = from;
+
+        for(auto node = m_leaf_parents[hint_leaf]; node >= 0; node = m_nodes[node].parent) {
+            auto distance = node_distance(static_cast<std::size_t>(node), position);
+            auto& flat_node = m_nodes[node];
+            auto next = flat_node.children[(distance >= 0.0f) ? 0 : 1];
+
+            auto normal_length = m_plane_x[node] * m_plane_x[node] + m_plane_y[node] * m_plane_y[node] + m_plane_z[node] * m_plane_z[node];
+            auto squared = distance * distance / normal_length;
+
+            if(next != from) {
+                // The point has crossed this plane so everything
+                // below it is no longer on the path to the point
+                child = next;
+                nearest = squared;
+            }
+            else {
+                nearest = std::min(nearest, squared);
+            }
+
+            from = node;
+        }
+    }
+
+    while(child >= 0) {
+        auto distance = node_distance(static_cast<std::size_t>(child), position);
+        auto normal_length = m_plane_x[child] * m_plane_x[child] + m_plane_y[child] * m_plane_y[child];
+        normal_length += m_plane_z[child] * m_plane_z[child];
+
+        nearest = std::min(nearest, distance * distance / normal_length);
+        child = m_nodes[child].children[(distance >= 0.0f) ? 0 : 1];
+    }
+
+    clearance = std::sqrt(nearest);
+
+    return (child == LEVEL_CHILD_NONE) ? -1 : ~child;
+}
+
+void Level::find_leaf_indices(std::span<const Eigen::Vector3f> positions, std::span<std::int32_t> out_leaves) const
+{
+    qf::throw_if<std::invalid_argument>(positions.size() != out_leaves.size(), "positions and out_leaves sizes don't match");
+
+    jobs::parallel_for(positions.size(), FIND_LEAF_JOB_GRAIN, [this, positions, out_leaves](std::size_t begin, std::size_t end) {
+        find_leaf_range(positions.subspan(begin, end - begin), out_leaves.subspan(begin, end - begin));
+    });
+}
+
+void Level::find_leaf_range(std::span<const Eigen::Vector3f> positions, std::span<std::int32_t> out_leaves) const
+{
+    for(std::size_t base = 0; base < positions.size(); base += FIND_LEAF_PACKET) {
+        auto count = std::min(FIND_LEAF_PACKET, positions.size() - base);
+
+        FindLeafPacket position_x, position_y, position_z;
+        std::array<std::int32_t, FIND_LEAF_PACKET> cursors;
+
+        for(std::size_t lane = 0; lane < FIND_LEAF_PACKET; ++lane) {
+            if(lane < count) {
+                assert(positions[base + lane].allFinite());
+
+                position_x[lane] = positions[base + lane].x();
+                position_y[lane] = positions[base + lane].y();
+                position_z[lane] = positions[base + lane].z();
+                cursors[lane] = m_root_node;
+            }
+            else {
+                position_x[lane] = 0.0f;
+                position_y[lane] = 0.0f;
+                position_z[lane] = 0.0f;
+                cursors[lane] = LEVEL_CHILD_NONE;
+            }
+        }
+
+        // Every lane descends on its own; lanes that have already
+        // reached a leaf test against a zero plane and stay in place
+        while(true) {
+            FindLeafPacket plane_x, plane_y, plane_z, plane_d;
+            bool any_active = false;
+
+            for(std::size_t lane = 0; lane < FIND_LEAF_PACKET; ++lane) {
+                auto node = cursors[lane];
+
+                if(node >= 0) {
+                    plane_x[lane] = m_plane_x[node];
+                    plane_y[lane] = m_plane_y[node];
+                    plane_z[lane] = m_plane_z[node];
+                    plane_d[lane] = m_plane_d[node];
+                    any_active = true;
+                }
+                else {
+                    plane_x[lane] = 0.0f;
+                    plane_y[lane] = 0.0f;
+                    plane_z[lane] = 0.0f;
+                    plane_d[lane] = 0.0f;
+                }
+            }
+
+            if(!any_active) {
+                break;
+            }
+
+            // Summed in the same order as node_distance so that
+            // points lying on a plane end up in the same leaf
+            FindLeafPacket distances = plane_x * position_x;
+            distances += plane_y * position_y;
+            distances += plane_z * position_z;
+            distances += plane_d;
+
+            for(std::size_t lane = 0; lane < FIND_LEAF_PACKET; ++lane) {
+                auto node = cursors[lane];
+
+                if(node >= 0) {
+                    cursors[lane] = m_nodes[node].children[(distances[lane] >= 0.0f) ? 0 : 1];
+                }
+            }
+        }
+
+        for(std::size_t lane = 0; lane < count; ++lane) {
+            out_leaves[base + lane] = (cursors[lane] == LEVEL_CHILD_NONE) ? -1 : ~cursors[lane];
+        }
+    }
+}
+
+Level::TraceResult Level::trace(const Eigen::Vector3f& start, const Eigen::Vector3f& end) const
+{
+    std::vector<PendingTrace> stack;
+    stack.reserve(64);
+
+    return trace_internal(start, end, stack);
+}
+
+void Level::trace_rays(std::span<const Ray> rays, std::span<TraceResult> out_results) const
+{
+    qf::throw_if<std::invalid_argument>(rays.size() != out_results.size(), "rays and out_results sizes don't match");
+
+    jobs::parallel_for(rays.size(), TRACE_RAYS_JOB_GRAIN, [this, rays, out_results](std::size_t begin, std::size_t end) {
+        std::vector<PendingTrace> stack;
+        stack.reserve(64);
+
+        for(std::size_t i = begin; i < end; ++i) {
+            out_results[i] = trace_internal(rays[i].start, rays[i].end, stack);
+        }
+    });
+}
+
+Level::BoxTraceResult Level::trace_box(const Eigen::Vector3f& start, const Eigen::Vector3f& end, const Eigen::Vector3f& mins,
+    const Eigen::Vector3f& maxs, std::uint32_t contents_mask) const
+{
+    assert(start.allFinite());
+    assert(end.allFinite());
+
+    BoxTraceResult result;
+    result.fraction = 1.0f;
+    result.start_solid = false;
+    result.all_solid = false;
+    result.brush = -1;
+    result.contents = 0;
+    result.normal = Eigen::Vector3f::Zero();
+
+    if(m_brushes.empty() || m_brush_list_offsets.empty()) {
+        return result;
+    }
+
+    static thread_local BoxTraceScratch scratch;
+
+    if(scratch.brush_marks.size() < m_brushes.size()) {
+        scratch.brush_marks.resize(m_brushes.size(), 0);
+    }
+
+    scratch.checkcount += 1;
+
+    if(scratch.checkcount == 0) {
+        std::fill(scratch.brush_marks.begin(), scratch.brush_marks.end(), 0);
+        scratch.checkcount = 1;
+    }
+
+    // Nodes are tested against the center of the box
+    // pushed out by half of its size along the plane normal
+    Eigen::Vector3f center = 0.5f * (mins + maxs);
+    Eigen::Vector3f half_size = 0.5f * (maxs - mins);
+    Eigen::Vector3f center_start = start + center;
+    Eigen::Vector3f center_end = end + center;
+
+    Eigen::AlignedBox3f sweep_bounds(start.cwiseMin(end) + mins, start.cwiseMax(end) + maxs);
+
+    auto& stack = scratch.stack;
+    stack.clear();
+    stack.push_back(PendingTrace { m_root_node, -1, 0.0f, 1.0f });
+
+    while(!stack.empty()) {
+        auto pending = stack.back();
+        stack.pop_back();
+
+        // Whatever lies beyond a hit that's
+        // already been found doesn't matter
+        if(pending.t0 > result.fraction) {
+            continue;
+        }
+
+        auto child = pending.child;
+        auto parent = pending.node;
+
+        while(child >= 0) {
+            float offset;
+
+            if(m_nodes[child].plane_type < PLANE_ANY) {
+                offset = half_size[m_nodes[child].plane_type];
+            }
+            else {
+                offset = std::abs(m_plane_x[child]) * half_size.x();
+                offset += std::abs(m_plane_y[child]) * half_size.y();
+                offset += std::abs(m_plane_z[child]) * half_size.z();
+            }
+
+            auto start_distance = node_distance(child, center_start);
+            auto end_distance = node_distance(child, center_end);
+
+            auto distance_0 = start_distance + pending.t0 * (end_distance - start_distance);
+            auto distance_1 = start_distance + pending.t1 * (end_distance - start_distance);
+
+            parent = child;
+
+            if(distance_0 >= offset && distance_1 >= offset) {
+                child = m_nodes[parent].children[0];
+                continue;
+            }
+
+            if(distance_0 < -offset && distance_1 < -offset) {
+                child = m_nodes[parent].children[1];
+                continue;
+            }
+
+            if(start_distance == end_distance) {
+                stack.push_back(PendingTrace { m_nodes[parent].children[1], parent, pending.t0, pending.t1 });
+                child = m_nodes[parent].children[0];
+                continue;
+            }
+
+            // The box straddles the plane over a stretch of the
+            // sweep; both halves cover that stretch, widened a bit
+            // so that rounding errors don't let the box slip through
+            auto near_side = (start_distance < end_distance) ? 1 : 0;
+            auto slab = (near_side ? offset : -offset) + (near_side ? TRACE_EPSILON : -TRACE_EPSILON);
+            auto inverse = 1.0f / (start_distance - end_distance);
+            auto near_end = std::clamp((start_distance - slab) * inverse, pending.t0, pending.t1);
+            auto far_start = std::clamp((start_distance + slab) * inverse, pending.t0, pending.t1);
+
+            stack.push_back(PendingTrace { m_nodes[parent].children[near_side ^ 1], parent, far_start, pending.t1 });
+
+            pending.t1 = near_end;
+            child = m_nodes[parent].children[near_side];
+        }
+
+        auto list_index = brush_list_index(child, parent);
+        auto list_begin = m_brush_list_offsets[list_index];
+        auto list_end = m_brush_list_offsets[list_index + 1];
+
+        for(auto i = list_begin; i < list_end; ++i) {
+            auto brush_index = m_brush_lists[i];
+
+            if(scratch.brush_marks[brush_index] == scratch.checkcount) {
+                continue;
+            }
+
+            scratch.brush_marks[brush_index] = scratch.checkcount;
+
+            const auto& brush = m_brushes[brush_index];
+
+            if((brush.contents & contents_mask) && brush.bounds.intersects(sweep_bounds)) {
+                clip_box_to_brush(brush_index, start, end, mins, maxs, result);
+
+                if(result.all_solid) {
+                    return result;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void Level::enumerate_visible(std::int32_t from_leaf, const Eigen::Vector3f& position, std::vector<std::int32_t>& out_leaves) const
+{
+    out_leaves.clear();
+
+    auto visible = vis_set(from_leaf);
+
+    enumerate_internal(visible.get(), position, nullptr, out_leaves);
+}
+
+void Level::enumerate_visible(std::int32_t from_leaf, const Eigen::Vector3f& position, const math::Frustum& frustum,
+    std::vector<std::int32_t>& out_leaves) const
+{
+    out_leaves.clear();
+
+    auto visible = vis_set(from_leaf);
+
+    enumerate_internal(visible.get(), position, &frustum, out_leaves);
+}
+
+std::shared_ptr<const Level::VisSet> Level::vis_set(std::int32_t from_leaf) const
+{
+    if(from_leaf < 0 || static_cast<std::size_t>(from_leaf) >= m_leaves.size() || m_pvs.size() != m_cluster_count) {
+        return nullptr; // out of bounds, assume everything is visible
+    }
+
+    auto from_cluster = m_leaves[from_leaf].cluster;
+
+    {
+        std::scoped_lock lock(m_vis_mutex);
+
+        m_vis_clock += 1;
+
+        for(auto& cached : m_vis_sets) {
+            if(cached.vis_set->from_cluster == from_cluster) {
+                cached.last_use = m_vis_clock;
+                return cached.vis_set;
+            }
+        }
+    }
+
+    // Building a set takes a while so it's done
+    // without holding the lock; should another thread
+    // beat us to it, its set is used instead of ours
+    auto new_set = build_vis_set(from_cluster);
+
+    std::scoped_lock lock(m_vis_mutex);
+
+    for(auto& cached : m_vis_sets) {
+        if(cached.vis_set->from_cluster == from_cluster) {
+            cached.last_use = m_vis_clock;
+            return cached.vis_set;
+        }
+    }
+
+    if(m_vis_sets.size() < VIS_SET_CACHE_SIZE) {
+        m_vis_sets.push_back(CachedVisSet { new_set, m_vis_clock });
+        return new_set;
+    }
+
+    auto least_recent = std::min_element(m_vis_sets.begin(), m_vis_sets.end(), [](const CachedVisSet& a, const CachedVisSet& b) {
+        return a.last_use < b.last_use;
+    });
+
+    least_recent->vis_set = new_set;
+    least_recent->last_use = m_vis_clock;
+
+    return new_set;
+}
+
+bool Level::is_visible(std::int32_t from_leaf, std::int32_t to_leaf) const
+{
+    if(from_leaf < 0 || to_leaf < 0 || static_cast<std::size_t>(from_leaf) >= m_leaves.size()) {
+        return true; // out of bounds, assume visible
+    }
+
+    if(static_cast<std::size_t>(to_leaf) >= m_leaves.size()) {
+        return false;
+    }
+
+    auto from_cluster = static_cast<std::size_t>(m_leaves[from_leaf].cluster);
+    auto to_cluster = static_cast<std::size_t>(m_leaves[to_leaf].cluster);
+
+    return m_pvs.is_visible(from_cluster, to_cluster);
+}
+
+bool Level::is_audible(std::int32_t from_leaf, std::int32_t to_leaf) const
+{
+    if(from_leaf < 0 || to_leaf < 0 || static_cast<std::size_t>(from_leaf) >= m_leaves.size() || m_pas.size() == 0) {
+        return true; // out of bounds, assume audible
+    }
+
+    if(static_cast<std::size_t>(to_leaf) >= m_leaves.size()) {
+        return false;
+    }
+
+    auto from_cluster = static_cast<std::size_t>(m_leaves[from_leaf].cluster);
+    auto to_cluster = static_cast<std::size_t>(m_leaves[to_leaf].cluster);
+
+    return m_pas.is_visible(from_cluster, to_cluster);
+}
+
+void Level::enumerate(const Eigen::Vector3f& position, std::vector<std::int32_t>& out_leaves) const
+{
+    out_leaves.clear();
+
+    enumerate_internal(nullptr, position, nullptr, out_leaves);
+}
+
+float Level::node_distance(std::size_t node_index, const Eigen::Vector3f& position) const noexcept
+{
+    // Axial planes have exact zeros in the other components,
+    // which add nothing; switching on the plane type instead
+    // mispredicts on every other node of a mixed tree
+    auto distance = m_plane_x[node_index] * position.x();
+    distance += m_plane_y[node_index] * position.y();
+    distance += m_plane_z[node_index] * position.z();
+    return distance + m_plane_d[node_index];
+}
+
+Level::TraceResult Level::trace_internal(const Eigen::Vector3f& start, const Eigen::Vector3f& end, std::vector<PendingTrace>& stack) const
+{
+    assert(start.allFinite());
+    assert(end.allFinite());
+
+    TraceResult result;
+    result.fraction = 1.0f;
+    result.start_solid = false;
+    result.leaf = -1;
+    result.plane_node = -1;
+    result.normal = Eigen::Vector3f::Zero();
+
+    stack.clear();
+    stack.push_back(PendingTrace { m_root_node, -1, 0.0f, 1.0f });
+
+    // Segments are split at node planes and the half nearest
+    // to the start is always traced first, so the first solid
+    // space the trace runs into is also the closest one
+    while(!stack.empty()) {
+        auto pending = stack.back();
+        stack.pop_back();
+
+        auto child = pending.child;
+
+        while(child >= 0) {
+            auto start_distance = node_distance(child, start);
+            auto end_distance = node_distance(child, end);
+
+            auto distance_0 = start_distance + pending.t0 * (end_distance - start_distance);
+            auto distance_1 = start_distance + pending.t1 * (end_distance - start_distance);
+
+            if(distance_0 >= 0.0f && distance_1 >= 0.0f) {
+                child = m_nodes[child].children[0];
+                continue;
+            }
+
+            if(distance_0 < 0.0f && distance_1 < 0.0f) {
+                child = m_nodes[child].children[1];
+                continue;
+            }
+
+            auto near_side = (distance_0 >= 0.0f) ? 0 : 1;
+            auto split = std::clamp(start_distance / (start_distance - end_distance), pending.t0, pending.t1);
+
+            stack.push_back(PendingTrace { m_nodes[child].children[near_side ^ 1], child, split, pending.t1 });
+
+            pending.t1 = split;
+            child = m_nodes[child].children[near_side];
+        }
+
+        if(child != LEVEL_CHILD_NONE) {
+            result.leaf = ~child;
+            continue;
+        }
+
+        if(pending.node < 0) {
+            result.fraction = 0.0f;
+            result.start_solid = true;
+            return result;
+        }
+
+        auto start_distance = node_distance(pending.node, start);
+        auto end_distance = node_distance(pending.node, end);
+        auto offset = (start_distance >= 0.0f) ? TRACE_EPSILON : -TRACE_EPSILON;
+
+        result.fraction = std::clamp((start_distance - offset) / (start_distance - end_distance), 0.0f, 1.0f);
+        result.plane_node = pending.node;
+        result.normal = plane(pending.node).normal();
+
+        if(start_distance < 0.0f) {
+            result.normal = -result.normal;
+        }
+
+        return result;
+    }
+
+    return result;
+}
+
+void Level::clip_box_to_brush(std::size_t brush_index, const Eigen::Vector3f& start, const Eigen::Vector3f& end,
+    const Eigen::Vector3f& mins, const Eigen::Vector3f& maxs, BoxTraceResult& result) const noexcept
+{
+    const auto& brush = m_brushes[brush_index];
+
+    auto enter_fraction = -1.0f;
+    auto leave_fraction = 1.0f;
+    auto enter_side = std::int32_t(-1);
+    auto starts_out = false;
+    auto gets_out = false;
+
+    for(auto i = brush.first_side; i < brush.first_side + brush.side_count; ++i) {
+        const auto& plane = m_brush_sides[i].plane;
+
+        // Push the side out by the box corner that
+        // lies the farthest behind it; the box then
+        // touches the brush when its origin does
+        Eigen::Vector3f corner = (plane.normal().array() < 0.0f).select(maxs.array(), mins.array()).matrix();
+        auto offset = plane.offset() + plane.normal().dot(corner);
+
+        auto start_distance = plane.normal().dot(start) + offset;
+        auto end_distance = plane.normal().dot(end) + offset;
+
+        starts_out = starts_out || start_distance > 0.0f;
+        gets_out = gets_out || end_distance > 0.0f;
+
+        if(start_distance > 0.0f && (end_distance >= TRACE_EPSILON || end_distance >= start_distance)) {
+            return; // the whole sweep is in front of the side
+        }
+
+        if(start_distance <= 0.0f && end_distance <= 0.0f) {
+            continue;
+        }
+
+        if(start_distance > end_distance) {
+            auto fraction = (start_distance - TRACE_EPSILON) / (start_distance - end_distance);
+
+            if(fraction > enter_fraction) {
+                enter_fraction = fraction;
+                enter_side = i;
+            }
+        }
+        else {
+            auto fraction = (start_distance + TRACE_EPSILON) / (start_distance - end_distance);
+            leave_fraction = std::min(leave_fraction, fraction);
+        }
+    }
+
+    if(!starts_out) {
+        result.start_solid = true;
+
+        if(!gets_out) {
+            result.all_solid = true;
+            result.fraction = 0.0f;
+            result.brush = static_cast<std::int32_t>(brush_index);
+            result.contents = brush.contents;
+        }
+
+        return;
+    }
+
+    if(enter_side >= 0 && enter_fraction < leave_fraction && enter_fraction < result.fraction) {
+        result.fraction = std::max(enter_fraction, 0.0f);
+        result.brush = static_cast<std::int32_t>(brush_index);
+        result.contents = brush.contents;
+        result.normal = m_brush_sides[enter_side].plane.normal();
+    }
+}
+
+std::size_t Level::brush_list_index(std::int32_t child, std::int32_t node) const noexcept
+{
+    if(child != LEVEL_CHILD_NONE) {
+        return static_cast<std::size_t>(~child);
+    }
+
+    if(node >= 0) {
+        return m_leaves.size() + static_cast<std::size_t>(node);
+    }
+
+    return m_leaves.size() + m_nodes.size();
+}
+
+void Level::link_brushes(void)
+{
+    m_brush_list_offsets.clear();
+    m_brush_lists.clear();
+
+    for(const auto& brush : m_brushes) {
+        auto sides_valid = brush.first_side >= 0 && brush.side_count >= 0;
+        sides_valid = sides_valid && static_cast<std::size_t>(brush.first_side) + brush.side_count <= m_brush_sides.size();
+        qf::throw_if_not<std::runtime_error>(sides_valid, "brush sides out of bounds");
+    }
+
+    if(m_brushes.empty()) {
+        return;
+    }
+
+    // Brushes are pushed down the tree by their bounds;
+    // space that no leaf covers is solid and that's where
+    // most of the brushes end up, so it gets lists too
+    std::vector<std::pair<std::size_t, std::int32_t>> links;
+    std::vector<std::pair<std::int32_t, std::int32_t>> stack;
+
+    for(std::size_t i = 0; i < m_brushes.size(); ++i) {
+        const auto& bounds = m_brushes[i].bounds;
+
+        if(bounds.isEmpty()) {
+            continue;
+        }
+
+        stack.clear();
+        stack.emplace_back(m_root_node, -1);
+
+        while(!stack.empty()) {
+            auto [child, node] = stack.back();
+            stack.pop_back();
+
+            if(child < 0) {
+                auto list_index = brush_list_index(child, node);
+
+                // Both children of a node can be solid
+                if(links.empty() || links.back() != std::make_pair(list_index, static_cast<std::int32_t>(i))) {
+                    links.emplace_back(list_index, static_cast<std::int32_t>(i));
+                }
+
+                continue;
+            }
+
+            Eigen::Vector3f normal(m_plane_x[child], m_plane_y[child], m_plane_z[child]);
+            auto sides = math::box_on_plane_side(bounds.min(), bounds.max(), normal, m_plane_d[child], m_nodes[child].plane_type,
+                m_nodes[child].plane_signbits);
+
+            if(sides & PLANE_SIDE_BACK) {
+                stack.emplace_back(m_nodes[child].children[1], child);
+            }
+
+            if(sides & PLANE_SIDE_FRONT) {
+                stack.emplace_back(m_nodes[child].children[0], child);
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> offsets(m_leaves.size() + m_nodes.size() + 2, 0);
+
+    for(const auto& link : links) {
+        offsets[link.first + 1] += 1;
+    }
+
+    for(std::size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<std::int32_t> lists(links.size());
+    std::vector<std::uint32_t> positions(offsets.begin(), offsets.end() - 1);
+
+    for(const auto& link : links) {
+        lists[positions[link.first]++] = link.second;
+    }
+
+    m_brush_list_offsets = std::move(offsets);
+    m_brush_lists = std::move(lists);
+}
+
+void Level::enumerate_internal(const VisSet* vis_set, const Eigen::Vector3f& position, const math::Frustum* frustum,
+    std::vector<std::int32_t>& out_leaves) const
+{
+    assert(position.allFinite());
+
+    struct PendingChild final {
+        std::int32_t child;
+        unsigned int plane_mask; ///< Frustum planes the child isn't known to be inside of yet
+    };
+
+    auto has_bounds = frustum && m_node_bounds.size() == m_nodes.size() && m_leaf_bounds.size() == m_leaves.size();
+
+    std::vector<PendingChild> stack;
+    stack.reserve(64);
+    stack.push_back(PendingChild { m_root_node, has_bounds ? FRUSTUM_ALL_PLANES : 0U });
+
+    while(!stack.empty()) {
+        auto child = stack.back().child;
+        auto plane_mask = stack.back().plane_mask;
+        stack.pop_back();
+
+        // The near side waits on the stack while the far
+        // side is walked right away, so the leaves come out
+        // ordered back to front with one push per node
+        while(child != LEVEL_CHILD_NONE) {
+            // A plane mask is only ever set with a frustum
+            if(frustum && plane_mask) {
+                const auto& bounds = (child >= 0) ? m_node_bounds[child] : m_leaf_bounds[~child];
+
+                if(frustum->cull_box(bounds, plane_mask)) {
+                    break;
+                }
+            }
+
+            if(child < 0) {
+                auto leaf_index = ~child;
+
+                if(!vis_set || (vis_set->leaf_bits[leaf_index / 64] & (UINT64_C(1) << (leaf_index % 64)))) {
+                    out_leaves.push_back(leaf_index);
+                }
+
+                break;
+            }
+
+            if(vis_set && !(vis_set->node_bits[child / 64] & (UINT64_C(1) << (child % 64)))) {
+                break;
+            }
+
+            auto distance = node_distance(child, position);
+            auto near_side = (distance >= 0.0f) ? 0 : 1;
+
+            stack.push_back(PendingChild { m_nodes[child].children[near_side], plane_mask });
+            child = m_nodes[child].children[near_side ^ 1];
+        }
+    }
+}
+
+std::shared_ptr<const Level::VisSet> Level::build_vis_set(std::int32_t from_cluster) const
+{
+    auto new_set = std::make_shared<VisSet>();
+    new_set->from_cluster = from_cluster;
+    new_set->leaf_bits.resize(utils::bitset_words(m_leaves.size()), UINT64_C(0));
+    new_set->node_bits.resize((m_nodes.size() + 63) / 64, UINT64_C(0));
+
+    std::vector<std::uint64_t> cluster_bits(m_pvs.row_words());
+    m_pvs.decompress_row(static_cast<std::size_t>(from_cluster), cluster_bits);
+
+    for(auto cluster : utils::set_bits(cluster_bits)) {
+        if(cluster >= m_cluster_count) {
+            break;
+        }
+
+        for(auto i = m_cluster_offsets[cluster]; i < m_cluster_offsets[cluster + 1]; ++i) {
+            auto leaf = m_cluster_leaves[i];
+            new_set->leaf_bits[leaf / 64] |= UINT64_C(1) << (leaf % 64);
+        }
+    }
+
+    for(auto leaf : utils::set_bits(new_set->leaf_bits)) {
+        auto leaf_index = static_cast<std::int32_t>(leaf);
+        new_set->leaves.push_back(leaf_index);
+
+        for(auto node = m_leaf_parents[leaf_index]; node >= 0; node = m_nodes[node].parent) {
+            auto& node_word = new_set->node_bits[node / 64];
+            auto node_bit = UINT64_C(1) << (node % 64);
+
+            if(node_word & node_bit) {
+                break;
+            }
+
+            node_word |= node_bit;
+        }
+    }
+
+    return new_set;
+}
+
+void Level::invalidate_vis_sets(void) const noexcept
+{
+    std::scoped_lock lock(m_vis_mutex);
+
+    m_vis_sets.clear();
+}
+
+void Level::update_clusters(void)
+{
+    auto cluster_count = std::size_t(0);
+
+    for(const auto& leaf : m_leaves) {
+        qf::throw_if<std::runtime_error>(leaf.cluster >= static_cast<std::int64_t>(m_leaves.size()), "cluster index out of bounds");
+
+        if(leaf.cluster >= 0) {
+            cluster_count = std::max(cluster_count, static_cast<std::size_t>(leaf.cluster) + 1);
+        }
+    }
+
+    for(auto& leaf : m_leaves) {
+        if(leaf.cluster < 0) {
+            leaf.cluster = static_cast<std::int32_t>(cluster_count++);
+        }
+    }
+
+    std::vector<std::uint32_t> offsets(cluster_count + 1, 0);
+    std::vector<std::int32_t> cluster_leaves(m_leaves.size());
+
+    for(const auto& leaf : m_leaves) {
+        offsets[leaf.cluster + 1] += 1;
+    }
+
+    for(std::size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<std::uint32_t> positions(offsets.begin(), offsets.end() - 1);
+
+    for(std::size_t i = 0; i < m_leaves.size(); ++i) {
+        cluster_leaves[positions[m_leaves[i].cluster]++] = static_cast<std::int32_t>(i);
+    }
+
+    m_cluster_count = cluster_count;
+    m_cluster_offsets = std::move(offsets);
+    m_cluster_leaves = std::move(cluster_leaves);
+}
+
+void Level::remap_pvs(void)
+{
+    if(m_pvs.size() == 0 || m_leaves.empty() || m_pvs.size() == m_cluster_count) {
+        return;
+    }
+
+    // Files with per-node rows predate clusters,
+    // so every leaf is a cluster of its own there
+    if(m_pvs.size() == m_record_count && m_cluster_count == m_leaves.size()) {
+        m_pvs.select(m_leaf_records);
+        return;
+    }
+
+    LOG_WARNING("PVS size ({}) doesn't match the cluster count ({}), ignoring PVS", m_pvs.size(), m_cluster_count);
+
+    m_pvs.clear();
+}
+
+void Level::build_pas(void)
+{
+    m_pas.clear();
+
+    auto leafcnt = m_pvs.size();
+    auto row_words = m_pvs.row_words();
+
+    if(leafcnt == 0) {
+        return;
+    }
+
+    std::vector<std::uint64_t> pvs_rows(leafcnt * row_words);
+    std::vector<std::uint64_t> pas_rows(leafcnt * row_words);
+
+    for(std::size_t i = 0; i < leafcnt; ++i) {
+        m_pvs.decompress_row(i, std::span(pvs_rows).subspan(i * row_words, row_words));
+    }
 
-    auto version = buffer.read<std::uint32_t>();
-    auto lumpcnt = buffer.read<std::uint32_t>();
+    for(std::size_t i = 0; i < leafcnt; ++i) {
+        auto pvs_row = std::span<const std::uint64_t>(pvs_rows).subspan(i * row_words, row_words);
+        auto pas_row = std::span(pas_rows).subspan(i * row_words, row_words);
 
-    qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
-    qf::throw_if_not<std::runtime_error>(version == QFLV_VERSION, "unsupported file version");
-    qf::throw_if_not<std::runtime_error>(lumpcnt > 0, "no lumps present");
+        std::copy(pvs_row.begin(), pvs_row.end(), pas_row.begin());
 
-    purge();
+        for(auto leaf : utils::set_bits(pvs_row)) {
+            utils::bitset_or(pas_row, std::span<const std::uint64_t>(pvs_rows).subspan(leaf * row_words, row_words));
+        }
+    }
+
+    m_pas.compress(leafcnt, pas_rows);
+}
 
+void Level::load_sequential(ReadBuffer& buffer, std::uint32_t lumpcnt, std::uint32_t flags)
+{
     std::unordered_set<std::uint32_t> loaded_lumps;
 
     for(std::uint32_t i = 0; i < lumpcnt; ++i) {
@@ -96,34 +1662,7 @@ void Level::load(std::string_view path)
 
         qf::throw_if_fmt<std::runtime_error>(loaded_lumps.contains(lumptype), "lump {} present twice", lumptype);
 
-        switch(lumptype) {
-            case LUMP_BSP:
-                read_lump_bsp(buffer);
-                break;
-
-            case LUMP_PVS:
-                read_lump_pvs(buffer);
-                break;
-
-            case LUMP_MAT:
-                read_lump_mat(buffer);
-                break;
-
-            case LUMP_ENT:
-                read_lump_ent(buffer);
-                break;
-
-            case LUMP_RAD:
-                read_lump_rad(buffer);
-                break;
-
-            case LUMP_VTX:
-                read_lump_vtx(buffer);
-                break;
-
-            default:
-                throw qf::runtime_error("unknown lump type: {}", lumptype);
-        }
+        read_lump(lumptype, buffer);
 
         loaded_lumps.insert(lumptype);
     }
@@ -141,260 +1680,225 @@ void Level::load(std::string_view path)
 
     qf::throw_if_not<std::runtime_error>(inv_signature_valid, "invalid file signature");
 
-    if(!buffer.is_ended()) {
-        LOG_WARNING("{}: garbage data after expected end-of-file", path_unfucked);
+    if(flags & LEVELFLAG_NO_RENDER) {
+        // Version 1 files don't store lump sizes so there
+        // is no way to skip render-only lumps without decoding
+        // them; the best we can do is to drop them afterwards
+        m_indices = std::vector<std::uint32_t>();
+        m_vertices = std::vector<LevelVertex>();
     }
 }
 
-void Level::save(std::string_view path) const
+void Level::load_directory(ReadBuffer& buffer, std::uint32_t lumpcnt, std::uint32_t flags)
 {
-    WriteBuffer buffer;
-
-    buffer.write<std::uint8_t>(MAGIC_BYTE_0);
-    buffer.write<std::uint8_t>(MAGIC_BYTE_1);
-    buffer.write<std::uint8_t>(MAGIC_BYTE_2);
-    buffer.write<std::uint8_t>(MAGIC_BYTE_3);
-
-    std::uint32_t lumpcnt = 0;
+    auto directory_size = QFLV_HEADER_SIZE + QFLV_LUMPINFO_SIZE * static_cast<std::size_t>(lumpcnt);
 
-    if(m_nodes.size()) {
-        lumpcnt += 1; // LUMP_BSP
-    }
-
-    if(m_pvs.size()) {
-        lumpcnt += 1; // LUMP_PVS
-    }
+    qf::throw_if<std::runtime_error>(directory_size + QFLV_TRAILER_SIZE > buffer.size(), "unexpected end-of-file");
 
-    if(m_materials.size()) {
-        lumpcnt += 1; // LUMP_MAT
-    }
+    std::vector<LumpInfo> lumps(lumpcnt);
+    std::unordered_set<std::uint32_t> known_lumps;
 
-    if(m_registry.view<entt::entity>().size()) {
-        lumpcnt += 1; // LUMP_ENT
-    }
+    for(auto& info : lumps) {
+        info.type = buffer.read<std::uint32_t>();
+        info.offset = buffer.read<std::uint32_t>();
+        info.size = buffer.read<std::uint32_t>();
+        info.flags = buffer.read<std::uint32_t>();
 
-    if(m_vertices.size() && m_indices.size()) {
-        lumpcnt += 1; // LUMP_VTX
-    }
+        auto lump_begin = static_cast<std::size_t>(info.offset);
+        auto lump_end = lump_begin + static_cast<std::size_t>(info.size);
 
-    buffer.write<std::uint32_t>(QFLV_VERSION);
-    buffer.write<std::uint32_t>(lumpcnt);
+        qf::throw_if_fmt<std::runtime_error>(known_lumps.contains(info.type), "lump {} present twice", info.type);
+        qf::throw_if_fmt<std::runtime_error>(lump_begin < directory_size, "lump {} overlaps the directory", info.type);
+        qf::throw_if_fmt<std::runtime_error>(lump_end > buffer.size() - QFLV_TRAILER_SIZE, "lump {} is out of bounds", info.type);
 
-    if(m_nodes.size()) {
-        buffer.write<std::uint32_t>(LUMP_BSP);
-        write_lump_bsp(buffer);
+        known_lumps.insert(info.type);
     }
 
-    if(m_pvs.size()) {
-        buffer.write<std::uint32_t>(LUMP_PVS);
-        write_lump_pvs(buffer);
-    }
+    auto trailer = buffer.slice(buffer.size() - QFLV_TRAILER_SIZE, QFLV_TRAILER_SIZE);
 
-    if(m_materials.size()) {
-        buffer.write<std::uint32_t>(LUMP_MAT);
-        write_lump_mat(buffer);
-    }
+    auto inv_signature_valid = true;
+    inv_signature_valid = inv_signature_valid && trailer.read<std::uint8_t>() == MAGIC_BYTE_3;
+    inv_signature_valid = inv_signature_valid && trailer.read<std::uint8_t>() == MAGIC_BYTE_2;
+    inv_signature_valid = inv_signature_valid && trailer.read<std::uint8_t>() == MAGIC_BYTE_1;
+    inv_signature_valid = inv_signature_valid && trailer.read<std::uint8_t>() == MAGIC_BYTE_0;
 
-    if(m_registry.view<entt::entity>().size()) {
-        buffer.write<std::uint32_t>(LUMP_ENT);
-        write_lump_ent(buffer);
-    }
+    qf::throw_if_not<std::runtime_error>(inv_signature_valid, "invalid file signature");
 
-    if(m_vertices.size() && m_indices.size()) {
-        buffer.write<std::uint32_t>(LUMP_VTX);
-        write_lump_vtx(buffer);
-    }
+    // Every lump decodes into its own set of members, so
+    // big lumps can safely be decoded on worker threads while
+    // the small ones are taken care of right here and now
+    std::vector<ReadBuffer> views(lumpcnt);
+    std::vector<std::exception_ptr> errors(lumpcnt);
+    jobs::Counter counter;
 
-    buffer.write<std::uint8_t>(MAGIC_BYTE_3);
-    buffer.write<std::uint8_t>(MAGIC_BYTE_2);
-    buffer.write<std::uint8_t>(MAGIC_BYTE_1);
-    buffer.write<std::uint8_t>(MAGIC_BYTE_0);
+    try {
+        for(std::size_t i = 0; i < lumps.size(); ++i) {
+            const auto& info = lumps[i];
 
-    auto file = buffer.to_file(path);
-    qf::throw_if_not<std::runtime_error>(file, utils::physfs_error());
+            if((info.flags & LUMPFLAG_RENDER) && (flags & LEVELFLAG_NO_RENDER)) {
+                continue;
+            }
 
-    PHYSFS_close(file);
-}
+            if(!is_known_lump(info.type)) {
+                LOG_WARNING("skipping unknown lump type: {}", info.type);
+                continue;
+            }
 
-bool Level::load_safe(std::string_view path) noexcept
-{
-    try {
-        load(path);
-        return true;
-    }
-    catch(const std::exception& ex) {
-        LOG_WARNING("{}: load failed: {}", path, ex.what());
-        return false;
-    }
-    catch(...) {
-        LOG_WARNING("{}: load failed", path);
-        return false;
-    }
-}
+            auto& view = views[i];
+            view = buffer.slice(info.offset, info.size);
+
+            if(info.size >= QFLV_ASYNC_LUMP_SIZE) {
+                jobs::submit([this, &info, &view, &error = errors[i]] {
+                    try {
+                        read_lump(info.type, view);
+                    }
+                    catch(...) {
+                        error = std::current_exception();
+                    }
+                }, &counter);
+            }
+        }
 
-bool Level::save_safe(std::string_view path) const noexcept
-{
-    try {
-        save(path);
-        return true;
-    }
-    catch(const std::exception& ex) {
-        LOG_WARNING("{}: save failed: {}", path, ex.what());
-        return false;
+        for(std::size_t i = 0; i < lumps.size(); ++i) {
+            if(views[i].data() && lumps[i].size < QFLV_ASYNC_LUMP_SIZE) {
+                read_lump(lumps[i].type, views[i]);
+            }
+        }
     }
     catch(...) {
-        LOG_WARNING("{}: save failed", path);
-        return false;
-    }
-}
-
-std::int32_t Level::find_leaf_index(const Eigen::Vector3f& position) const
-{
-    return find_leaf_index_internal(m_root_node, position);
-}
-
-void Level::enumerate_visible(std::int32_t from_leaf, const Eigen::Vector3f& position, std::vector<const Node*>& out_nodes) const
-{
-    out_nodes.clear();
-
-    enumerate_visible_internal(m_root_node, from_leaf, position, out_nodes);
-}
-
-bool Level::is_visible(std::int32_t from_leaf, std::int32_t to_leaf) const
-{
-    if(from_leaf < 0 || from_leaf >= m_pvs.size() || to_leaf < 0) {
-        return true; // out of bounds, assume visible
+        // Worker threads still write into the views and
+        // errors that live on this stack frame, so they must
+        // be done before the exception is let out of here
+        jobs::wait(counter);
+        throw;
     }
 
-    const auto& from_pvs = m_pvs[from_leaf];
-    auto block_index = static_cast<std::size_t>(to_leaf / 32);
-    auto bit_flag = static_cast<std::uint32_t>(1u << (to_leaf % 32));
+    jobs::wait(counter);
 
-    if(block_index < from_pvs.size()) {
-        return from_pvs[block_index] & bit_flag;
+    for(const auto& error : errors) {
+        if(error) {
+            // This re-throws whatever went wrong
+            // while decoding the lump on a worker thread
+            std::rethrow_exception(error);
+        }
     }
-
-    return false;
 }
 
-void Level::enumerate(const Eigen::Vector3f& position, std::vector<const Node*>& out_nodes) const
+bool Level::is_known_lump(std::uint32_t lumptype) noexcept
 {
-    out_nodes.clear();
-
-    enumerate_internal(m_root_node, position, out_nodes);
+    switch(lumptype) {
+        case LUMP_BSP:
+        case LUMP_PVS:
+        case LUMP_MAT:
+        case LUMP_ENT:
+        case LUMP_RAD:
+        case LUMP_VTX:
+        case LUMP_VIS:
+        case LUMP_ECS:
+        case LUMP_PVX:
+        case LUMP_BOX:
+        case LUMP_BRS:
+        case LUMP_BSD:
+        case LUMP_PAS:
+        case LUMP_CLS:
+            return true;
+
+        default:
+            return false;
+    }
 }
 
-std::int32_t Level::find_leaf_index_internal(std::int32_t node_index, const Eigen::Vector3f& position) const
+void Level::read_lump(std::uint32_t lumptype, ReadBuffer& buffer)
 {
-    assert(position.allFinite());
-
-    if(node_index >= 0 && node_index < m_nodes.size()) {
-        const auto node = &m_nodes[node_index];
+    switch(lumptype) {
+        case LUMP_BSP:
+            read_lump_bsp(buffer);
+            break;
 
-        if(const auto leaf = std::get_if<Leaf>(node)) {
-            return node_index;
-        }
+        case LUMP_PVS:
+            read_lump_pvs(buffer);
+            break;
 
-        if(const auto internal = std::get_if<Internal>(node)) {
-            auto distance = internal->plane.signedDistance(position);
+        case LUMP_MAT:
+            read_lump_mat(buffer);
+            break;
 
-            if(distance >= 0.0f) {
-                return find_leaf_index_internal(internal->front, position);
-            }
-            else {
-                return find_leaf_index_internal(internal->back, position);
-            }
-        }
+        case LUMP_ENT:
+            read_lump_ent(buffer);
+            break;
 
-        throw qf::logic_error("invalid variant state of Node::data");
-    }
+        case LUMP_RAD:
+            read_lump_rad(buffer);
+            break;
 
-    return -1;
-}
+        case LUMP_VTX:
+            read_lump_vtx(buffer);
+            break;
 
-void Level::enumerate_visible_internal(std::int32_t node_index, std::int32_t from_leaf, const Eigen::Vector3f& position,
-    std::vector<const Node*>& out_nodes) const
-{
-    assert(position.allFinite());
+        case LUMP_VIS:
+            read_lump_vis(buffer);
+            break;
 
-    if(node_index >= 0 && node_index < m_nodes.size()) {
-        const auto node = &m_nodes[node_index];
+        case LUMP_ECS:
+            read_lump_ecs(buffer);
+            break;
 
-        if(const auto internal = std::get_if<Internal>(node)) {
-            auto distance = internal->plane.signedDistance(position);
+        case LUMP_PVX:
+            read_lump_pvx(buffer);
+            break;
 
-            if(distance >= 0.0f) {
-                enumerate_visible_internal(internal->back, from_leaf, position, out_nodes);
-                out_nodes.push_back(node);
-                enumerate_visible_internal(internal->front, from_leaf, position, out_nodes);
-            }
-            else {
-                enumerate_visible_internal(internal->front, from_leaf, position, out_nodes);
-                out_nodes.push_back(node);
-                enumerate_visible_internal(internal->back, from_leaf, position, out_nodes);
-            }
-        }
-        else if(const auto leaf = std::get_if<Leaf>(node)) {
-            if(is_visible(from_leaf, node_index)) {
-                out_nodes.push_back(node);
-            }
-        }
+        case LUMP_BOX:
+            read_lump_box(buffer);
+            break;
 
-        throw qf::logic_error("invalid variant state of Node::data");
-    }
-}
+        case LUMP_BRS:
+            read_lump_brs(buffer);
+            break;
 
-void Level::enumerate_internal(std::int32_t node_index, const Eigen::Vector3f& position, std::vector<const Node*>& out_nodes) const
-{
-    assert(position.allFinite());
+        case LUMP_BSD:
+            read_lump_bsd(buffer);
+            break;
 
-    if(node_index >= 0 && node_index < m_nodes.size()) {
-        const auto node = &m_nodes[node_index];
+        case LUMP_PAS:
+            read_lump_pas(buffer);
+            break;
 
-        if(const auto internal = std::get_if<Internal>(node)) {
-            auto distance = internal->plane.signedDistance(position);
+        case LUMP_CLS:
+            read_lump_cls(buffer);
+            break;
 
-            if(distance >= 0.0f) {
-                enumerate_internal(internal->back, position, out_nodes);
-                out_nodes.push_back(node);
-                enumerate_internal(internal->front, position, out_nodes);
-            }
-            else {
-                enumerate_internal(internal->front, position, out_nodes);
-                out_nodes.push_back(node);
-                enumerate_internal(internal->back, position, out_nodes);
-            }
-        }
-        else {
-            out_nodes.push_back(node);
-        }
+        default:
+            throw qf::runtime_error("unknown lump type: {}", lumptype);
     }
 }
 
 void Level::read_lump_bsp(ReadBuffer& buffer)
 {
-    auto nodecnt = buffer.read<std::uint32_t>();
+    auto nodecnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
     auto rootnode = buffer.read<std::int32_t>();
 
-    m_nodes.clear();
-    m_nodes.reserve(nodecnt);
-
     qf::throw_if<std::runtime_error>(nodecnt == 0, "empty geometry lump");
-    qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    qf::throw_if<std::runtime_error>(nodecnt * BSP_VALUES_PER_NODE * sizeof(std::uint32_t) > buffer.remaining(), "unexpected end-of-file");
 
-    for(std::uint32_t i = 0; i < nodecnt; ++i) {
-        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    std::vector<std::uint32_t> values(nodecnt * BSP_VALUES_PER_NODE);
+    buffer.read_span<std::uint32_t>(values);
+
+    std::vector<Node> nodes;
+    nodes.reserve(nodecnt);
 
-        auto plane_i = buffer.read<float>();
-        auto plane_j = buffer.read<float>();
-        auto plane_k = buffer.read<float>();
-        auto plane_d = buffer.read<float>();
-        auto leaf_index = buffer.read<std::int32_t>();
-        auto front_index = buffer.read<std::int32_t>();
-        auto back_index = buffer.read<std::int32_t>();
-        auto material_index = buffer.read<std::int32_t>();
-        auto ebo_offset = buffer.read<std::int32_t>();
-        auto ebo_count = buffer.read<std::int32_t>();
+    for(std::size_t i = 0; i < nodecnt; ++i) {
+        auto record = &values[i * BSP_VALUES_PER_NODE];
+
+        auto plane_i = std::bit_cast<float>(record[0]);
+        auto plane_j = std::bit_cast<float>(record[1]);
+        auto plane_k = std::bit_cast<float>(record[2]);
+        auto plane_d = std::bit_cast<float>(record[3]);
+        auto leaf_index = std::bit_cast<std::int32_t>(record[4]);
+        auto front_index = std::bit_cast<std::int32_t>(record[5]);
+        auto back_index = std::bit_cast<std::int32_t>(record[6]);
+        auto material_index = std::bit_cast<std::int32_t>(record[7]);
+        auto ebo_offset = std::bit_cast<std::int32_t>(record[8]);
+        auto ebo_count = std::bit_cast<std::int32_t>(record[9]);
 
         if(leaf_index >= 0) {
             Leaf leaf;
@@ -402,7 +1906,7 @@ void Level::read_lump_bsp(ReadBuffer& buffer)
             leaf.ebo_offset = ebo_offset;
             leaf.ebo_count = ebo_count;
 
-            m_nodes.emplace_back(std::move(leaf));
+            nodes.emplace_back(std::move(leaf));
         }
         else {
             Internal internal;
@@ -410,47 +1914,41 @@ void Level::read_lump_bsp(ReadBuffer& buffer)
             internal.front = front_index;
             internal.back = back_index;
 
-            m_nodes.emplace_back(std::move(internal));
+            nodes.emplace_back(std::move(internal));
         }
     }
 
-    qf::throw_if<std::runtime_error>(rootnode < 0 || rootnode >= m_nodes.size(), "invalid root node index");
-
-    for(std::uint32_t i = 0; i < m_nodes.size(); ++i) {
-        const auto node = &m_nodes[i];
-
-        if(const auto internal = std::get_if<Internal>(node)) {
-            qf::throw_if<std::runtime_error>(internal->front >= m_nodes.size(), "invalid front node index");
-            qf::throw_if<std::runtime_error>(internal->back >= m_nodes.size(), "invalid back node index");
-        }
-    }
+    set_nodes(nodes, rootnode);
 }
 
 void Level::read_lump_pvs(ReadBuffer& buffer)
 {
-    auto nodecnt = buffer.read<std::uint32_t>();
+    auto nodecnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
 
     qf::throw_if<std::runtime_error>(nodecnt == 0, "empty PVS lump");
-    qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    qf::throw_if<std::runtime_error>(nodecnt * nodecnt > buffer.size() / sizeof(std::uint32_t), "unexpected end-of-file");
 
-    std::vector<std::uint32_t> pvsentry;
-    pvsentry.reserve(nodecnt);
+    // Legacy lumps store nodecnt 32-bit words per row
+    // regardless of how many of them are actually meaningful
+    auto bytes = buffer.read_view(nodecnt * nodecnt * sizeof(std::uint32_t));
 
-    for(std::uint32_t i = 0; i < nodecnt; ++i) {
-        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    qf::throw_if<std::runtime_error>(bytes.size() != nodecnt * nodecnt * sizeof(std::uint32_t), "unexpected end-of-file");
 
-        pvsentry.clear();
+    auto used_words = (nodecnt + 31) / 32;
+    auto row_words = (nodecnt + 63) / 64;
 
-        for(std::uint32_t j = 0; j < nodecnt; ++j) {
-            qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    std::vector<std::uint64_t> rows(nodecnt * row_words, UINT64_C(0));
 
-            pvsentry.push_back(buffer.read<std::uint32_t>());
-        }
+    for(std::size_t i = 0; i < nodecnt; ++i) {
+        auto row_bytes = &bytes[i * nodecnt * sizeof(std::uint32_t)];
 
-        m_pvs.push_back(pvsentry);
+        for(std::size_t j = 0; j < used_words; ++j) {
+            auto word = static_cast<std::uint64_t>(load_u32be(&row_bytes[j * sizeof(std::uint32_t)]));
+            rows[i * row_words + j / 2] |= word << (32 * (j % 2));
+        }
     }
 
-    qf::throw_if_not<std::runtime_error>(nodecnt == m_pvs.size(), "PVS size mismatch");
+    m_pvs.compress(nodecnt, rows);
 }
 
 void Level::read_lump_mat(ReadBuffer& buffer)
@@ -472,11 +1970,12 @@ void Level::read_lump_mat(ReadBuffer& buffer)
 
 void Level::read_lump_ent(ReadBuffer& buffer)
 {
-    std::string source;
-    source.resize(buffer.read<std::uint32_t>());
-    buffer.read(source.data(), source.size());
+    auto source_size = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+    auto source_bytes = buffer.read_view(source_size);
 
-    qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    qf::throw_if<std::runtime_error>(source_bytes.size() != source_size, "unexpected end-of-file");
+
+    std::string source(reinterpret_cast<const char*>(source_bytes.data()), source_bytes.size());
 
     const auto jsonv = json_parse_string(source.c_str());
     qf::throw_if_not<std::runtime_error>(jsonv, "json syntax error");
@@ -514,104 +2013,235 @@ void Level::read_lump_rad(ReadBuffer& buffer)
     // empty
 }
 
+void Level::read_lump_vis(ReadBuffer& buffer)
+{
+    auto leafcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+
+    qf::throw_if<std::runtime_error>(leafcnt == 0, "empty PVS lump");
+
+    read_compressed_rows(buffer, leafcnt, m_pvs);
+}
+
+void Level::read_lump_pas(ReadBuffer& buffer)
+{
+    auto leafcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+
+    qf::throw_if<std::runtime_error>(leafcnt == 0, "empty PAS lump");
+
+    read_compressed_rows(buffer, leafcnt, m_pas);
+}
+
+void Level::read_lump_cls(ReadBuffer& buffer)
+{
+    auto leafcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+
+    qf::throw_if<std::runtime_error>(leafcnt * sizeof(std::int32_t) > buffer.remaining(), "unexpected end-of-file");
+
+    m_cluster_records.resize(leafcnt);
+    buffer.read_span<std::int32_t>(m_cluster_records);
+}
+
+void Level::read_lump_ecs(ReadBuffer& buffer)
+{
+    components::decode_registry(m_registry, buffer);
+}
+
 void Level::read_lump_vtx(ReadBuffer& buffer)
 {
-    m_indices.resize(buffer.read<std::uint32_t>());
+    auto indexcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
 
-    for(std::size_t i = 0; i < m_indices.size(); ++i) {
-        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    qf::throw_if<std::runtime_error>(indexcnt * sizeof(std::uint32_t) > buffer.remaining(), "unexpected end-of-file");
 
-        m_indices[i] = buffer.read<std::uint32_t>();
-    }
+    m_indices.resize(indexcnt);
+    buffer.read_span<std::uint32_t>(m_indices);
 
-    m_vertices.resize(buffer.read<std::uint32_t>());
+    auto vertexcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
 
-    for(std::size_t i = 0; i < m_vertices.size(); ++i) {
-        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+    qf::throw_if<std::runtime_error>(vertexcnt * VTX_FLOATS_PER_VERTEX * sizeof(float) > buffer.remaining(), "unexpected end-of-file");
 
-        LevelVertex vertex;
+    // Vertex components are converted in bulk first and
+    // only then scattered into LevelVertex, which is padded
+    // because of Eigen::Vector4f alignment requirements
+    std::vector<float> components(vertexcnt * VTX_FLOATS_PER_VERTEX);
+    buffer.read_span<float>(components);
 
-        vertex.position.x() = buffer.read<float>();
-        vertex.position.y() = buffer.read<float>();
-        vertex.position.z() = buffer.read<float>();
+    m_vertices.resize(vertexcnt);
+
+    for(std::size_t i = 0; i < vertexcnt; ++i) {
+        auto& vertex = m_vertices[i];
+        auto values = &components[i * VTX_FLOATS_PER_VERTEX];
+
+        vertex.position = Eigen::Vector3f(values[0], values[1], values[2]);
         assert(vertex.position.allFinite());
 
-        vertex.normal.x() = buffer.read<float>();
-        vertex.normal.y() = buffer.read<float>();
-        vertex.normal.z() = buffer.read<float>();
+        vertex.normal = Eigen::Vector3f(values[3], values[4], values[5]);
         assert(vertex.normal.allFinite());
 
-        vertex.tangent.x() = buffer.read<float>();
-        vertex.tangent.y() = buffer.read<float>();
-        vertex.tangent.z() = buffer.read<float>();
-        vertex.tangent.w() = buffer.read<float>();
+        vertex.tangent = Eigen::Vector4f(values[6], values[7], values[8], values[9]);
         assert(vertex.tangent.allFinite());
 
-        vertex.texcoord.x() = buffer.read<float>();
-        vertex.texcoord.y() = buffer.read<float>();
+        vertex.texcoord = Eigen::Vector2f(values[10], values[11]);
         assert(vertex.texcoord.allFinite());
 
-        vertex.lightmap.x() = buffer.read<float>();
-        vertex.lightmap.y() = buffer.read<float>();
+        vertex.lightmap = Eigen::Vector2f(values[12], values[13]);
         assert(vertex.lightmap.allFinite());
-
-        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
     }
 }
 
-void Level::write_lump_bsp(WriteBuffer& buffer) const
+void Level::read_lump_pvx(ReadBuffer& buffer)
 {
-    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(m_nodes.size()));
+    auto indexcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
 
-    for(std::int32_t i = 0; i < m_nodes.size(); ++i) {
-        const auto node = &m_nodes[i];
+    qf::throw_if<std::runtime_error>(indexcnt * sizeof(std::uint32_t) > buffer.remaining(), "unexpected end-of-file");
 
-        if(const auto leaf = std::get_if<Leaf>(node)) {
-            buffer.write<float>(std::numeric_limits<float>::quiet_NaN());
-            buffer.write<float>(std::numeric_limits<float>::quiet_NaN());
-            buffer.write<float>(std::numeric_limits<float>::quiet_NaN());
-            buffer.write<float>(std::numeric_limits<float>::quiet_NaN());
+    m_indices.resize(indexcnt);
+    buffer.read_span<std::uint32_t>(m_indices);
 
-            buffer.write<std::int32_t>(i);
-            buffer.write<std::int32_t>(-1);
-            buffer.write<std::int32_t>(-1);
+    auto vertexcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+    auto chunkcnt = (vertexcnt + PACKED_VERTEX_CHUNK - 1) / PACKED_VERTEX_CHUNK;
 
-            buffer.write<std::int32_t>(leaf->material);
-            buffer.write<std::int32_t>(leaf->ebo_offset);
-            buffer.write<std::int32_t>(leaf->ebo_count);
-        }
-        else if(const auto internal = std::get_if<Internal>(node)) {
-            buffer.write<float>(internal->plane.coeffs()[0]);
-            buffer.write<float>(internal->plane.coeffs()[1]);
-            buffer.write<float>(internal->plane.coeffs()[2]);
-            buffer.write<float>(internal->plane.coeffs()[3]);
+    auto chunks_size = chunkcnt * PVX_FLOATS_PER_CHUNK * sizeof(float);
+    auto vertices_size = vertexcnt * sizeof(PackedLevelVertex);
+
+    qf::throw_if<std::runtime_error>(chunks_size + vertices_size > buffer.remaining(), "unexpected end-of-file");
+
+    std::vector<float> chunk_bounds(chunkcnt * PVX_FLOATS_PER_CHUNK);
+    buffer.read_span<float>(chunk_bounds);
 
-            buffer.write<std::int32_t>(-1);
-            buffer.write<std::int32_t>(internal->front);
-            buffer.write<std::int32_t>(internal->back);
+    // The packed vertex is nothing but an array of 16-bit
+    // values, so it's converted from big-endian in one go
+    std::vector<PackedLevelVertex> packed(vertexcnt);
+    buffer.read_span<std::uint16_t>(std::span(reinterpret_cast<std::uint16_t*>(packed.data()), vertexcnt * PVX_VALUES_PER_VERTEX));
 
-            buffer.write<std::int32_t>(-1);
-            buffer.write<std::int32_t>(-1);
-            buffer.write<std::int32_t>(-1);
+    m_vertices.resize(vertexcnt);
+
+    for(std::size_t i = 0; i < chunkcnt; ++i) {
+        auto values = &chunk_bounds[i * PVX_FLOATS_PER_CHUNK];
+
+        Eigen::AlignedBox3f bounds(Eigen::Vector3f(values[0], values[1], values[2]), Eigen::Vector3f(values[3], values[4], values[5]));
+        qf::throw_if_not<std::runtime_error>(bounds.min().allFinite() && bounds.max().allFinite(), "invalid vertex chunk bounds");
+
+        auto chunk_begin = i * PACKED_VERTEX_CHUNK;
+        auto chunk_end = std::min(chunk_begin + PACKED_VERTEX_CHUNK, vertexcnt);
+
+        for(std::size_t j = chunk_begin; j < chunk_end; ++j) {
+            m_vertices[j] = unpack_level_vertex(packed[j], bounds);
         }
     }
 }
 
-void Level::write_lump_pvs(WriteBuffer& buffer) const
+void Level::read_lump_box(ReadBuffer& buffer)
 {
-    auto nodecnt = static_cast<std::uint32_t>(m_pvs.size());
+    auto leafcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
 
-    buffer.write<std::uint32_t>(nodecnt);
+    qf::throw_if<std::runtime_error>(leafcnt * BOX_FLOATS_PER_LEAF * sizeof(float) > buffer.remaining(), "unexpected end-of-file");
 
-    for(const auto& row : m_pvs) {
-        for(std::size_t i = 0; i < nodecnt; ++i) {
-            if(i < row.size()) {
-                buffer.write<std::uint32_t>(row[i]);
-            }
-            else {
-                buffer.write<std::uint32_t>(0);
-            }
+    std::vector<float> values(leafcnt * BOX_FLOATS_PER_LEAF);
+    buffer.read_span<float>(values);
+
+    m_leaf_bounds.resize(leafcnt);
+
+    for(std::size_t i = 0; i < leafcnt; ++i) {
+        auto record = values.data() + i * BOX_FLOATS_PER_LEAF;
+        m_leaf_bounds[i].min() = Eigen::Vector3f(record[0], record[1], record[2]);
+        m_leaf_bounds[i].max() = Eigen::Vector3f(record[3], record[4], record[5]);
+    }
+}
+
+void Level::read_lump_brs(ReadBuffer& buffer)
+{
+    auto brushcnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+
+    qf::throw_if<std::runtime_error>(brushcnt * BRS_VALUES_PER_BRUSH * sizeof(std::uint32_t) > buffer.remaining(),
+        "unexpected end-of-file");
+
+    std::vector<std::uint32_t> values(brushcnt * BRS_VALUES_PER_BRUSH);
+    buffer.read_span<std::uint32_t>(values);
+
+    m_brushes.resize(brushcnt);
+
+    for(std::size_t i = 0; i < brushcnt; ++i) {
+        auto record = &values[i * BRS_VALUES_PER_BRUSH];
+
+        auto& brush = m_brushes[i];
+        brush.bounds.min().x() = std::bit_cast<float>(record[0]);
+        brush.bounds.min().y() = std::bit_cast<float>(record[1]);
+        brush.bounds.min().z() = std::bit_cast<float>(record[2]);
+        brush.bounds.max().x() = std::bit_cast<float>(record[3]);
+        brush.bounds.max().y() = std::bit_cast<float>(record[4]);
+        brush.bounds.max().z() = std::bit_cast<float>(record[5]);
+        brush.first_side = std::bit_cast<std::int32_t>(record[6]);
+        brush.side_count = std::bit_cast<std::int32_t>(record[7]);
+        brush.contents = record[8];
+    }
+}
+
+void Level::read_lump_bsd(ReadBuffer& buffer)
+{
+    auto sidecnt = static_cast<std::size_t>(buffer.read<std::uint32_t>());
+
+    qf::throw_if<std::runtime_error>(sidecnt * BSD_FLOATS_PER_SIDE * sizeof(float) > buffer.remaining(), "unexpected end-of-file");
+
+    std::vector<float> values(sidecnt * BSD_FLOATS_PER_SIDE);
+    buffer.read_span<float>(values);
+
+    m_brush_sides.resize(sidecnt);
+
+    for(std::size_t i = 0; i < sidecnt; ++i) {
+        auto record = values.data() + i * BSD_FLOATS_PER_SIDE;
+        m_brush_sides[i].plane = Eigen::Hyperplane<float, 3>(Eigen::Vector3f(record[0], record[1], record[2]), record[3]);
+    }
+}
+
+void Level::write_lump_bsp(WriteBuffer& buffer) const
+{
+    // Internal nodes are written first and leaves
+    // follow in order, so leaf numbering survives a reload
+    auto internalcnt = static_cast<std::int32_t>(m_nodes.size());
+
+    auto child_record = [internalcnt](std::int32_t child) {
+        if(child >= 0) {
+            return child;
         }
+
+        if(child == LEVEL_CHILD_NONE) {
+            return -1;
+        }
+
+        return internalcnt + ~child;
+    };
+
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(m_nodes.size() + m_leaves.size()));
+    buffer.write<std::int32_t>(child_record(m_root_node));
+
+    for(std::size_t i = 0; i < m_nodes.size(); ++i) {
+        buffer.write<float>(m_plane_x[i]);
+        buffer.write<float>(m_plane_y[i]);
+        buffer.write<float>(m_plane_z[i]);
+        buffer.write<float>(m_plane_d[i]);
+
+        buffer.write<std::int32_t>(-1);
+        buffer.write<std::int32_t>(child_record(m_nodes[i].children[0]));
+        buffer.write<std::int32_t>(child_record(m_nodes[i].children[1]));
+
+        buffer.write<std::int32_t>(-1);
+        buffer.write<std::int32_t>(-1);
+        buffer.write<std::int32_t>(-1);
+    }
+
+    for(std::size_t i = 0; i < m_leaves.size(); ++i) {
+        buffer.write<float>(std::numeric_limits<float>::quiet_NaN());
+        buffer.write<float>(std::numeric_limits<float>::quiet_NaN());
+        buffer.write<float>(std::numeric_limits<float>::quiet_NaN());
+        buffer.write<float>(std::numeric_limits<float>::quiet_NaN());
+
+        buffer.write<std::int32_t>(internalcnt + static_cast<std::int32_t>(i));
+        buffer.write<std::int32_t>(-1);
+        buffer.write<std::int32_t>(-1);
+
+        buffer.write<std::int32_t>(m_leaves[i].material);
+        buffer.write<std::int32_t>(m_leaves[i].ebo_offset);
+        buffer.write<std::int32_t>(m_leaves[i].ebo_count);
     }
 }
 
@@ -642,9 +2272,12 @@ void Level::write_lump_ent(WriteBuffer& buffer) const
         json_object_set_value(json, id_string.c_str(), value);
     }
 
-    std::string source;
-    source.assign(json_serialize_to_string(jsonv));
+    auto serialized = json_serialize_to_string(jsonv);
+    qf::throw_if_not<std::runtime_error>(serialized, "json serialization failed");
+
+    std::string source(serialized);
 
+    json_free_serialized_string(serialized);
     json_value_free(jsonv);
 
     buffer.write<std::uint32_t>(static_cast<std::uint32_t>(source.size()));
@@ -659,31 +2292,129 @@ void Level::write_lump_rad(WriteBuffer& buffer) const
 void Level::write_lump_vtx(WriteBuffer& buffer) const
 {
     buffer.write<std::uint32_t>(static_cast<std::uint32_t>(m_indices.size()));
+    buffer.write_span<std::uint32_t>(m_indices);
 
-    for(auto index : m_indices) {
-        buffer.write<std::uint32_t>(index);
+    std::vector<float> components;
+    components.reserve(m_vertices.size() * VTX_FLOATS_PER_VERTEX);
+
+    for(const auto& vertex : m_vertices) {
+        components.insert(components.end(), vertex.position.data(), vertex.position.data() + 3);
+        components.insert(components.end(), vertex.normal.data(), vertex.normal.data() + 3);
+        components.insert(components.end(), vertex.tangent.data(), vertex.tangent.data() + 4);
+        components.insert(components.end(), vertex.texcoord.data(), vertex.texcoord.data() + 2);
+        components.insert(components.end(), vertex.lightmap.data(), vertex.lightmap.data() + 2);
     }
 
     buffer.write<std::uint32_t>(static_cast<std::uint32_t>(m_vertices.size()));
+    buffer.write_span<float>(components);
+}
 
-    for(const auto& vertex : m_vertices) {
-        buffer.write<float>(vertex.position.x());
-        buffer.write<float>(vertex.position.y());
-        buffer.write<float>(vertex.position.z());
+void Level::write_lump_pvx(WriteBuffer& buffer) const
+{
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(m_indices.size()));
+    buffer.write_span<std::uint32_t>(m_indices);
+
+    auto vertexcnt = m_vertices.size();
+    auto chunkcnt = (vertexcnt + PACKED_VERTEX_CHUNK - 1) / PACKED_VERTEX_CHUNK;
+
+    std::vector<float> chunk_bounds;
+    chunk_bounds.reserve(chunkcnt * PVX_FLOATS_PER_CHUNK);
+
+    std::vector<PackedLevelVertex> packed;
+    packed.reserve(vertexcnt);
+
+    for(std::size_t i = 0; i < chunkcnt; ++i) {
+        auto chunk_begin = i * PACKED_VERTEX_CHUNK;
+        auto chunk_end = std::min(chunk_begin + PACKED_VERTEX_CHUNK, vertexcnt);
+
+        Eigen::AlignedBox3f bounds;
+
+        for(std::size_t j = chunk_begin; j < chunk_end; ++j) {
+            bounds.extend(m_vertices[j].position);
+        }
+
+        chunk_bounds.insert(chunk_bounds.end(), bounds.min().data(), bounds.min().data() + 3);
+        chunk_bounds.insert(chunk_bounds.end(), bounds.max().data(), bounds.max().data() + 3);
+
+        for(std::size_t j = chunk_begin; j < chunk_end; ++j) {
+            packed.push_back(pack_level_vertex(m_vertices[j], bounds));
+        }
+    }
+
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(vertexcnt));
+    buffer.write_span<float>(chunk_bounds);
+    buffer.write_span<std::uint16_t>(std::span(reinterpret_cast<const std::uint16_t*>(packed.data()), vertexcnt * PVX_VALUES_PER_VERTEX));
+}
+
+void Level::write_lump_box(WriteBuffer& buffer) const
+{
+    std::vector<float> values;
+    values.reserve(m_leaf_bounds.size() * BOX_FLOATS_PER_LEAF);
+
+    for(const auto& bounds : m_leaf_bounds) {
+        values.insert(values.end(), bounds.min().data(), bounds.min().data() + 3);
+        values.insert(values.end(), bounds.max().data(), bounds.max().data() + 3);
+    }
+
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(m_leaf_bounds.size()));
+    buffer.write_span<float>(values);
+}
+
+void Level::write_lump_brs(WriteBuffer& buffer) const
+{
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(m_brushes.size()));
+
+    for(const auto& brush : m_brushes) {
+        buffer.write<float>(brush.bounds.min().x());
+        buffer.write<float>(brush.bounds.min().y());
+        buffer.write<float>(brush.bounds.min().z());
+        buffer.write<float>(brush.bounds.max().x());
+        buffer.write<float>(brush.bounds.max().y());
+        buffer.write<float>(brush.bounds.max().z());
+
+        buffer.write<std::int32_t>(brush.first_side);
+        buffer.write<std::int32_t>(brush.side_count);
+        buffer.write<std::uint32_t>(brush.contents);
+    }
+}
+
+void Level::write_lump_bsd(WriteBuffer& buffer) const
+{
+    std::vector<float> values;
+    values.reserve(m_brush_sides.size() * BSD_FLOATS_PER_SIDE);
+
+    for(const auto& side : m_brush_sides) {
+        values.insert(values.end(), side.plane.coeffs().data(), side.plane.coeffs().data() + BSD_FLOATS_PER_SIDE);
+    }
+
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(m_brush_sides.size()));
+    buffer.write_span<float>(values);
+}
 
-        buffer.write<float>(vertex.normal.x());
-        buffer.write<float>(vertex.normal.y());
-        buffer.write<float>(vertex.normal.z());
+void Level::write_lump_vis(WriteBuffer& buffer) const
+{
+    write_compressed_rows(buffer, m_pvs);
+}
 
-        buffer.write<float>(vertex.tangent.x());
-        buffer.write<float>(vertex.tangent.y());
-        buffer.write<float>(vertex.tangent.z());
-        buffer.write<float>(vertex.tangent.w());
+void Level::write_lump_pas(WriteBuffer& buffer) const
+{
+    write_compressed_rows(buffer, m_pas);
+}
 
-        buffer.write<float>(vertex.texcoord.x());
-        buffer.write<float>(vertex.texcoord.y());
+void Level::write_lump_cls(WriteBuffer& buffer) const
+{
+    std::vector<std::int32_t> values;
+    values.reserve(m_leaves.size());
 
-        buffer.write<float>(vertex.lightmap.x());
-        buffer.write<float>(vertex.lightmap.y());
+    for(const auto& leaf : m_leaves) {
+        values.push_back(leaf.cluster);
     }
+
+    buffer.write<std::uint32_t>(static_cast<std::uint32_t>(values.size()));
+    buffer.write_span<std::int32_t>(values);
+}
+
+void Level::write_lump_ecs(WriteBuffer& buffer) const
+{
+    components::encode_registry(m_registry, buffer);
 }
@@ -2,13 +2,34 @@
 #define CORE_LEVEL_HH
 #pragma once
 
+#include "core/level/pvs.hh"
 #include "core/level/vertex.hh"
+#include "core/level/wide_tree.hh"
+
+constexpr static std::uint32_t LEVELFLAG_NO_RENDER = 1 << 0;    ///< Don't load render-only lumps (dedicated servers)
+constexpr static std::uint32_t LEVELFLAG_NO_PVS_CACHE = 1 << 1; ///< Keep PVS rows compressed and expand them on demand
+
+constexpr static std::uint32_t SAVEFLAG_JSON_ENTITIES = 1 << 0;  ///< Store entities as JSON for debugging
+constexpr static std::uint32_t SAVEFLAG_PACKED_VERTICES = 1 << 1; ///< Store vertices quantized, see PackedLevelVertex
+
+constexpr static std::int32_t LEVEL_CHILD_NONE = INT32_MIN; ///< Child reference that points to nothing
+
+constexpr static std::uint32_t CONTENTS_SOLID = 1 << 0;      ///< Brush blocks everything
+constexpr static std::uint32_t CONTENTS_PLAYERCLIP = 1 << 1; ///< Brush only blocks players
+constexpr static std::uint32_t CONTENTS_MASK_ALL = UINT32_MAX;
 
 class ReadBuffer;
 class WriteBuffer;
 
+namespace math
+{
+class Frustum;
+} // namespace math
+
 class Level final {
 public:
+    /// Internal node as it is authored and stored on disk;
+    /// front and back are indices in the authored node list
     struct Internal final {
         Eigen::Hyperplane<float, 3> plane;
         std::int32_t front { -1 };
@@ -19,10 +40,72 @@ public:
         std::int32_t ebo_offset;
         std::int32_t ebo_count;
         std::int32_t material;
+        std::int32_t cluster { -1 }; ///< Visibility cluster index, negative when the leaf is a cluster of its own
     };
 
     using Node = std::variant<Internal, Leaf>;
 
+    /// Internal node the way it is kept in memory; child references
+    /// that are non-negative are node indices, LEVEL_CHILD_NONE points
+    /// to nothing and other negative values are complemented leaf indices;
+    /// node planes are kept aside in separate per-component arrays
+    struct FlatNode final {
+        std::int32_t children[2];    ///< Front and back child references
+        std::int32_t parent;         ///< Parent node index, -1 for the root node
+        std::uint8_t plane_type;     ///< PLANE_* type of the node plane
+        std::uint8_t plane_signbits; ///< Sign bits of the node plane normal
+    };
+
+    /// Line segment to trace through the level
+    struct Ray final {
+        Eigen::Vector3f start;
+        Eigen::Vector3f end;
+    };
+
+    /// Outcome of a trace; space that no leaf covers (a child
+    /// reference to LEVEL_CHILD_NONE) is solid and stops traces
+    struct TraceResult final {
+        float fraction;          ///< Part of the segment covered before the hit, 1 if nothing was hit
+        bool start_solid;        ///< The segment starts in solid space
+        std::int32_t leaf;       ///< Last leaf the trace went through or -1 if it never left solid space
+        std::int32_t plane_node; ///< Node index of the hit plane or -1 if nothing was hit
+        Eigen::Vector3f normal;  ///< Hit plane normal facing the start of the segment
+    };
+
+    /// Convex collision volume; a point is within the brush
+    /// when it's behind every one of the brush sides
+    struct Brush final {
+        Eigen::AlignedBox3f bounds; ///< Bounding box of the brush
+        std::int32_t first_side;    ///< Index of the first side in the side list
+        std::int32_t side_count;    ///< Amount of sides
+        std::uint32_t contents;     ///< CONTENTS_* flags
+    };
+
+    /// Brush side; the plane normal faces out of the brush
+    struct BrushSide final {
+        Eigen::Hyperplane<float, 3> plane;
+    };
+
+    /// Outcome of a box trace
+    struct BoxTraceResult final {
+        float fraction;         ///< Part of the sweep covered before the hit, 1 if nothing was hit
+        bool start_solid;       ///< The box starts within a brush
+        bool all_solid;         ///< The box never leaves a brush, fraction is zero
+        std::int32_t brush;     ///< Index of the hit brush or -1 if nothing was hit
+        std::uint32_t contents; ///< Contents of the hit brush
+        Eigen::Vector3f normal; ///< Hit brush side normal
+    };
+
+    /// Leaves potentially visible from a viewer cluster along
+    /// with every internal node that has any of them below it;
+    /// traversals don't descend into nodes that aren't marked
+    struct VisSet final {
+        std::int32_t from_cluster;            ///< Viewer cluster index
+        std::vector<std::int32_t> leaves;     ///< Visible leaf indices in ascending order
+        std::vector<std::uint64_t> leaf_bits; ///< Visible leaves, one bit per leaf
+        std::vector<std::uint64_t> node_bits; ///< Marked internal nodes, one bit per node
+    };
+
     Level(void) = default;
     Level(const Level& other) = delete;
     Level& operator=(const Level& other) = delete;
@@ -35,45 +118,162 @@ public:
     void set_geometry(std::vector<std::uint32_t> new_indices, std::vector<LevelVertex> new_vertices) noexcept;
 
     constexpr std::int32_t root_node(void) const noexcept;
-    constexpr const std::vector<Node>& nodes(void) const noexcept;
-    void set_nodes(std::vector<Node> new_nodes, std::int32_t new_root) noexcept;
+    constexpr const std::vector<FlatNode>& nodes(void) const noexcept;
+    constexpr const std::vector<Leaf>& leaves(void) const noexcept;
+    Eigen::Hyperplane<float, 3> plane(std::size_t node_index) const noexcept;
+
+    /// Collapsed copy of the tree that set_nodes derives;
+    /// find_leaf_index walks it instead of the binary tree
+    constexpr const LevelWideTree& wide_tree(void) const noexcept;
+
+    /// Replace the tree with an authored one; internal nodes are
+    /// laid out depth-first and leaves are numbered in the order
+    /// they appear in the authored list; leaves without a cluster
+    /// get clusters of their own, numbered after the authored ones
+    /// @param new_nodes Authored nodes
+    /// @param new_root Index of the root node in new_nodes
+    /// @throws exceptions if the nodes don't form a tree
+    void set_nodes(const std::vector<Node>& new_nodes, std::int32_t new_root);
+
+    constexpr const std::vector<Eigen::AlignedBox3f>& node_bounds(void) const noexcept;
+    constexpr const std::vector<Eigen::AlignedBox3f>& leaf_bounds(void) const noexcept;
+
+    /// Recompute node and leaf bounding boxes; leaf bounds are the
+    /// volume the tree splits off for every leaf within the extent
+    /// of the geometry, or of the bounds lump when there's none,
+    /// without either of them traversals don't cull anything;
+    /// load() calls this, other callers do so after set_nodes
+    void update_bounds(void);
+
+    constexpr std::size_t cluster_count(void) const noexcept;
+
+    /// Merge visibility clusters whose PVS rows are identical and
+    /// convert the PVS to the merged clusters; nothing that was
+    /// potentially visible before becomes invisible, repeated until
+    /// no more clusters can be merged
+    void build_clusters(void);
+
+    constexpr const std::vector<Brush>& brushes(void) const noexcept;
+    constexpr const std::vector<BrushSide>& brush_sides(void) const noexcept;
+
+    /// Replace collision brushes; every brush is linked to
+    /// the leaves and the solid space its bounds reach, so it
+    /// has to be called after set_nodes, which drops the links
+    /// @param new_brushes Brushes
+    /// @param new_sides Brush sides
+    /// @throws exceptions if a brush refers to sides that don't exist
+    void set_brushes(std::vector<Brush> new_brushes, std::vector<BrushSide> new_sides);
 
     constexpr const std::vector<std::string>& materials(void) const noexcept;
     void set_materials(std::vector<std::string> new_materials) noexcept;
 
+    constexpr const LevelPVS& pvs(void) const noexcept;
+    constexpr const LevelPVS& pas(void) const noexcept;
+
+    /// Replace the PVS; the PAS is derived from it right away
+    /// @param new_pvs New potentially visible set, one row per cluster
+    void set_pvs(LevelPVS new_pvs);
+
     /// Purges a level
     void purge(void) noexcept;
 
     /// Load a level from file
     /// @param path Path to the level file
+    /// @param flags LEVELFLAG_* load flags
     /// @throws exceptions if anything bad happens
-    void load(std::string_view path);
+    void load(std::string_view path, std::uint32_t flags = 0);
 
     /// Save a level to file
     /// @param path Path to the level file
+    /// @param flags SAVEFLAG_* save flags
     /// @throws exceptions if anything bad happens
-    void save(std::string_view path) const;
+    void save(std::string_view path, std::uint32_t flags = 0) const;
 
     /// Load a level from file
     /// @param path Path to the level file
+    /// @param flags LEVELFLAG_* load flags
     /// @return True on success, false otherwise
-    bool load_safe(std::string_view path) noexcept;
+    bool load_safe(std::string_view path, std::uint32_t flags = 0) noexcept;
 
     /// Save a level to file
     /// @param path Path to the level file
+    /// @param flags SAVEFLAG_* save flags
     /// @return True on success, false otherwise
-    bool save_safe(std::string_view path) const noexcept;
+    bool save_safe(std::string_view path, std::uint32_t flags = 0) const noexcept;
 
     /// Locate a leaf index in which a point is located
     /// @param position Position to locate leaf for
     /// @return Leaf index or -1 if not found
     std::int32_t find_leaf_index(const Eigen::Vector3f& position) const;
 
-    /// Enumerate BSP nodes visible from a position
+    /// Locate leaf indices for many points at once; the points
+    /// are walked down the tree in packets which is considerably
+    /// faster than calling find_leaf_index for each of them, and
+    /// large batches are split between job system threads
+    /// @param positions Positions to locate leaves for
+    /// @param out_leaves Leaf indices or -1, must be the same size as positions
+    void find_leaf_indices(std::span<const Eigen::Vector3f> positions, std::span<std::int32_t> out_leaves) const;
+
+    /// Locate a leaf index starting from the leaf a point was
+    /// previously in; the planes above that leaf are checked bottom
+    /// up and the tree is only descended from the topmost plane the
+    /// point has crossed, which is cheap for points that barely move
+    /// @param position Position to locate leaf for
+    /// @param hint_leaf Leaf index the point was previously in or -1
+    /// @param clearance Distance the point can move from position without leaving the leaf
+    /// @return Leaf index or -1 if not found
+    std::int32_t find_leaf_index(const Eigen::Vector3f& position, std::int32_t hint_leaf, float& clearance) const;
+
+    /// Trace a line segment until it hits solid space; the end point
+    /// is kept slightly off the hit plane so that a trace starting
+    /// from it doesn't begin in solid space
+    /// @param start Segment start
+    /// @param end Segment end
+    /// @return Trace result
+    TraceResult trace(const Eigen::Vector3f& start, const Eigen::Vector3f& end) const;
+
+    /// Trace many segments at once; large batches are split
+    /// between job system threads and this is also safe to call
+    /// concurrently from several threads
+    /// @param rays Segments to trace
+    /// @param out_results Trace results, must be the same size as rays
+    void trace_rays(std::span<const Ray> rays, std::span<TraceResult> out_results) const;
+
+    /// Sweep a box against collision brushes; only the parts of the
+    /// tree the box can reach are descended and each brush is tested
+    /// at most once, no matter how many leaves it's linked to; this is
+    /// safe to call concurrently and doesn't allocate once warmed up
+    /// @param start Box origin at the start of the sweep
+    /// @param end Box origin at the end of the sweep
+    /// @param mins Box minimum corner relative to its origin
+    /// @param maxs Box maximum corner relative to its origin
+    /// @param contents_mask CONTENTS_* flags of brushes to collide with
+    /// @return Trace result
+    BoxTraceResult trace_box(const Eigen::Vector3f& start, const Eigen::Vector3f& end, const Eigen::Vector3f& mins,
+        const Eigen::Vector3f& maxs, std::uint32_t contents_mask = CONTENTS_MASK_ALL) const;
+
+    /// Enumerate leaves visible from a position, back to front
     /// @param from_leaf Leaf index of the viewer
     /// @param position Position of the viewer
-    /// @param out_nodes Output vector to store visible nodes
-    void enumerate_visible(std::int32_t from_leaf, const Eigen::Vector3f& position, std::vector<const Node*>& out_nodes) const;
+    /// @param out_leaves Output vector to store visible leaf indices
+    void enumerate_visible(std::int32_t from_leaf, const Eigen::Vector3f& position, std::vector<std::int32_t>& out_leaves) const;
+
+    /// Enumerate leaves visible from a position that are
+    /// also within a view frustum, back to front; subtrees whose
+    /// bounds are outside the frustum are skipped altogether
+    /// @param from_leaf Leaf index of the viewer
+    /// @param position Position of the viewer
+    /// @param frustum View frustum
+    /// @param out_leaves Output vector to store visible leaf indices
+    void enumerate_visible(std::int32_t from_leaf, const Eigen::Vector3f& position, const math::Frustum& frustum,
+        std::vector<std::int32_t>& out_leaves) const;
+
+    /// Get leaves potentially visible from a viewer leaf; sets of
+    /// the most recently used viewer clusters are cached, so any amount
+    /// of viewers within the same cluster share a single set
+    /// @param from_leaf Leaf index of the viewer
+    /// @return Visible set or nullptr if everything is visible
+    std::shared_ptr<const VisSet> vis_set(std::int32_t from_leaf) const;
 
     /// Performs a visibility check to see if one leaf can see another
     /// @param from_leaf Leaf index of the viewer
@@ -81,55 +281,200 @@ public:
     /// @return True if visible, false otherwise
     bool is_visible(std::int32_t from_leaf, std::int32_t to_leaf) const;
 
-    /// Enumerate BSP nodes starting from a position
+    /// Performs an audibility check to see if one leaf can hear another;
+    /// a leaf hears every leaf that any leaf visible from it can see
+    /// @param from_leaf Leaf index of the listener
+    /// @param to_leaf Leaf index of the source
+    /// @return True if audible, false otherwise
+    bool is_audible(std::int32_t from_leaf, std::int32_t to_leaf) const;
+
+    /// Enumerate all leaves, back to front as seen from a position
     /// @param position Position of the viewer
-    /// @param out_nodes Output vector to store nodes
-    void enumerate(const Eigen::Vector3f& position, std::vector<const Node*>& out_nodes) const;
+    /// @param out_leaves Output vector to store leaf indices
+    void enumerate(const Eigen::Vector3f& position, std::vector<std::int32_t>& out_leaves) const;
 
 private:
-    /// Locate a leaf index in which a point is located
-    /// @param node_index The node to recurse into
-    /// @param position Position to locate leaf for
-    /// @return Leaf index or -1 if not found
-    std::int32_t find_leaf_index_internal(std::int32_t node_index, const Eigen::Vector3f& position) const;
-
-    /// Enumerate BSP nodes visible from a position
-    /// @param node_index The node to recurse into
-    /// @param from_leaf Leaf index of the viewer
+    /// Signed distance from a node plane to a point; every
+    /// plane is measured with all of its components
+    /// @param node_index Internal node index
+    /// @param position Point to measure the distance to
+    /// @return Signed distance, positive in front of the plane
+    float node_distance(std::size_t node_index, const Eigen::Vector3f& position) const noexcept;
+
+    /// Enumerate leaves back to front as seen from a position
+    /// @param vis_set Visible set of the viewer or nullptr to skip visibility checks
     /// @param position Position of the viewer
-    /// @param out_nodes Output vector to store visible nodes
-    void enumerate_visible_internal(std::int32_t node_index, std::int32_t from_leaf, const Eigen::Vector3f& position,
-        std::vector<const Node*>& out_nodes) const;
+    /// @param frustum View frustum or nullptr to skip frustum checks
+    /// @param out_leaves Output vector to store leaf indices
+    void enumerate_internal(const VisSet* vis_set, const Eigen::Vector3f& position, const math::Frustum* frustum,
+        std::vector<std::int32_t>& out_leaves) const;
+
+    /// Private implementation of find_leaf_indices()
+    /// @param positions Positions to locate leaves for
+    /// @param out_leaves Leaf indices or -1, must be the same size as positions
+    void find_leaf_range(std::span<const Eigen::Vector3f> positions, std::span<std::int32_t> out_leaves) const;
+
+    /// Segment of a ray still to be traced; t0 and t1 are
+    /// fractions of the whole ray and node is the one whose
+    /// plane split the segment off, -1 for the initial one
+    struct PendingTrace final {
+        std::int32_t child;
+        std::int32_t node;
+        float t0;
+        float t1;
+    };
 
-    /// Enumerate BSP nodes starting from a position
-    /// @param node_index Node to recurse into
-    /// @param position Position of the viewer
-    /// @param out_nodes Output vector to store nodes
-    void enumerate_internal(std::int32_t node_index, const Eigen::Vector3f& position, std::vector<const Node*>& out_nodes) const;
+    /// Private implementation of trace() and trace_rays()
+    /// @param start Segment start
+    /// @param end Segment end
+    /// @param stack Scratch stack, reused between traces
+    /// @return Trace result
+    TraceResult trace_internal(const Eigen::Vector3f& start, const Eigen::Vector3f& end, std::vector<PendingTrace>& stack) const;
+
+    /// Per-thread scratch state of box traces; brush marks keep
+    /// the check count of the last trace that tested each brush,
+    /// so they never have to be cleared between traces
+    struct BoxTraceScratch final {
+        std::vector<PendingTrace> stack;
+        std::vector<std::uint32_t> brush_marks;
+        std::uint32_t checkcount { 0 };
+    };
 
+    /// Clip a box sweep against a single brush
+    /// @param brush_index Brush index
+    /// @param start Box origin at the start of the sweep
+    /// @param end Box origin at the end of the sweep
+    /// @param mins Box minimum corner relative to its origin
+    /// @param maxs Box maximum corner relative to its origin
+    /// @param result Trace result to update when the brush is hit closer
+    void clip_box_to_brush(std::size_t brush_index, const Eigen::Vector3f& start, const Eigen::Vector3f& end, const Eigen::Vector3f& mins,
+        const Eigen::Vector3f& maxs, BoxTraceResult& result) const noexcept;
+
+    /// Brush list index of a child reference; leaves come first,
+    /// then solid space below every internal node and then solid
+    /// space of a tree that has nothing but a solid root
+    /// @param child Leaf or solid child reference
+    /// @param node Internal node index the reference belongs to, -1 for the root
+    /// @return Brush list index
+    std::size_t brush_list_index(std::int32_t child, std::int32_t node) const noexcept;
+
+    /// Link brushes to the leaves and the solid space their bounds reach
+    /// @throws exceptions if a brush refers to sides that don't exist
+    void link_brushes(void);
+
+    /// Mark leaves visible from a viewer cluster and their
+    /// ancestors; walking up stops at the first node that's
+    /// already marked so every node is visited at most once
+    /// @param from_cluster Cluster index of the viewer, must be within the PVS
+    /// @return A new visible set
+    std::shared_ptr<const VisSet> build_vis_set(std::int32_t from_cluster) const;
+
+    /// Drop cached visible sets; called whenever nodes or PVS change
+    void invalidate_vis_sets(void) const noexcept;
+
+    /// Number leaves without a cluster and index leaves by cluster
+    void update_clusters(void);
+
+    /// Bring the PVS in line with cluster numbering; older files
+    /// index visibility rows by authored node index instead
+    void remap_pvs(void);
+
+    /// Derive the potentially audible set from the PVS; every
+    /// row is the union of PVS rows of leaves visible from the leaf
+    void build_pas(void);
+
+    /// Load lumps from a version 1 file; lumps are laid out
+    /// back to back and have to be decoded strictly in order
+    /// @param buffer Buffer positioned right after the header
+    /// @param lumpcnt Amount of lumps in the file
+    /// @param flags LEVELFLAG_* load flags
+    void load_sequential(ReadBuffer& buffer, std::uint32_t lumpcnt, std::uint32_t flags);
+
+    /// Load lumps from a version 2 file; the lump directory
+    /// allows lumps to be skipped or decoded concurrently
+    /// @param buffer Buffer positioned right after the header
+    /// @param lumpcnt Amount of lumps in the file
+    /// @param flags LEVELFLAG_* load flags
+    void load_directory(ReadBuffer& buffer, std::uint32_t lumpcnt, std::uint32_t flags);
+
+    static bool is_known_lump(std::uint32_t lumptype) noexcept;
+
+    void read_lump(std::uint32_t lumptype, ReadBuffer& buffer);
     void read_lump_bsp(ReadBuffer& buffer);
     void read_lump_pvs(ReadBuffer& buffer);
     void read_lump_mat(ReadBuffer& buffer);
     void read_lump_ent(ReadBuffer& buffer);
     void read_lump_rad(ReadBuffer& buffer);
     void read_lump_vtx(ReadBuffer& buffer);
+    void read_lump_vis(ReadBuffer& buffer);
+    void read_lump_ecs(ReadBuffer& buffer);
+    void read_lump_pvx(ReadBuffer& buffer);
+    void read_lump_box(ReadBuffer& buffer);
+    void read_lump_brs(ReadBuffer& buffer);
+    void read_lump_bsd(ReadBuffer& buffer);
+    void read_lump_pas(ReadBuffer& buffer);
+    void read_lump_cls(ReadBuffer& buffer);
 
     void write_lump_bsp(WriteBuffer& buffer) const;
-    void write_lump_pvs(WriteBuffer& buffer) const;
     void write_lump_mat(WriteBuffer& buffer) const;
     void write_lump_ent(WriteBuffer& buffer) const;
     void write_lump_rad(WriteBuffer& buffer) const;
     void write_lump_vtx(WriteBuffer& buffer) const;
+    void write_lump_vis(WriteBuffer& buffer) const;
+    void write_lump_ecs(WriteBuffer& buffer) const;
+    void write_lump_pvx(WriteBuffer& buffer) const;
+    void write_lump_box(WriteBuffer& buffer) const;
+    void write_lump_brs(WriteBuffer& buffer) const;
+    void write_lump_bsd(WriteBuffer& buffer) const;
+    void write_lump_pas(WriteBuffer& buffer) const;
+    void write_lump_cls(WriteBuffer& buffer) const;
 
     entt::registry m_registry;
 
-    std::vector<Node> m_nodes;
+    std::vector<FlatNode> m_nodes;
+    std::vector<float> m_plane_x;
+    std::vector<float> m_plane_y;
+    std::vector<float> m_plane_z;
+    std::vector<float> m_plane_d;
+    std::vector<Leaf> m_leaves;
+    std::vector<std::int32_t> m_leaf_parents; ///< Parent node index of every leaf, -1 for unreferenced or root leaves
+    LevelWideTree m_wide_tree;
+    std::vector<Eigen::AlignedBox3f> m_node_bounds;
+    std::vector<Eigen::AlignedBox3f> m_leaf_bounds;
+
+    std::size_t m_cluster_count { 0 };
+    std::vector<std::uint32_t> m_cluster_offsets; ///< Offsets into m_cluster_leaves, one per cluster and one past the end
+    std::vector<std::int32_t> m_cluster_leaves;   ///< Leaf indices grouped by cluster
+
+    std::vector<Brush> m_brushes;
+    std::vector<BrushSide> m_brush_sides;
+    std::vector<std::uint32_t> m_brush_list_offsets; ///< Offsets into m_brush_lists, see brush_list_index
+    std::vector<std::int32_t> m_brush_lists;
+
+    /// Authored node index of every leaf and the amount of
+    /// authored nodes; only needed to remap the PVS while loading
+    std::vector<std::uint32_t> m_leaf_records;
+    std::size_t m_record_count { 0 };
+
+    /// Cluster index of every leaf as stored on disk; only
+    /// needed to apply clusters once the tree is loaded
+    std::vector<std::int32_t> m_cluster_records;
     std::vector<std::string> m_materials;
-    std::vector<std::vector<std::uint32_t>> m_pvs;
+    LevelPVS m_pvs;
+    LevelPVS m_pas;
     std::vector<std::uint32_t> m_indices;
     std::vector<LevelVertex> m_vertices;
 
-    std::int32_t m_root_node;
+    std::int32_t m_root_node { LEVEL_CHILD_NONE };
+
+    struct CachedVisSet final {
+        std::shared_ptr<const VisSet> vis_set;
+        std::uint64_t last_use;
+    };
+
+    mutable std::mutex m_vis_mutex;
+    mutable std::vector<CachedVisSet> m_vis_sets;
+    mutable std::uint64_t m_vis_clock { 0 };
 };
 
 constexpr entt::registry& Level::registry(void) noexcept
@@ -157,14 +502,59 @@ constexpr std::int32_t Level::root_node(void) const noexcept
     return m_root_node;
 }
 
-constexpr const std::vector<Level::Node>& Level::nodes(void) const noexcept
+constexpr const std::vector<Level::FlatNode>& Level::nodes(void) const noexcept
 {
     return m_nodes;
 }
 
+constexpr const std::vector<Level::Leaf>& Level::leaves(void) const noexcept
+{
+    return m_leaves;
+}
+
+constexpr const LevelWideTree& Level::wide_tree(void) const noexcept
+{
+    return m_wide_tree;
+}
+
+constexpr const std::vector<Eigen::AlignedBox3f>& Level::node_bounds(void) const noexcept
+{
+    return m_node_bounds;
+}
+
+constexpr const std::vector<Eigen::AlignedBox3f>& Level::leaf_bounds(void) const noexcept
+{
+    return m_leaf_bounds;
+}
+
+constexpr std::size_t Level::cluster_count(void) const noexcept
+{
+    return m_cluster_count;
+}
+
+constexpr const std::vector<Level::Brush>& Level::brushes(void) const noexcept
+{
+    return m_brushes;
+}
+
+constexpr const std::vector<Level::BrushSide>& Level::brush_sides(void) const noexcept
+{
+    return m_brush_sides;
+}
+
 constexpr const std::vector<std::string>& Level::materials(void) const noexcept
 {
     return m_materials;
 }
 
+constexpr const LevelPVS& Level::pvs(void) const noexcept
+{
+    return m_pvs;
+}
+
+constexpr const LevelPVS& Level::pas(void) const noexcept
+{
+    return m_pas;
+}
+
 #endif
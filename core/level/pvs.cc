@@ -0,0 +1,202 @@
+#include "core/pch.hh"
+
+#include "core/level/pvs.hh"
+
+#include "core/exceptions.hh"
+
+static std::size_t row_bytes(std::size_t leafcnt) noexcept
+{
+    return (leafcnt + 7) / 8;
+}
+
+bool LevelPVS::is_visible(std::size_t from_leaf, std::size_t to_leaf) const noexcept
+{
+    if(from_leaf >= m_size) {
+        return true; // out of bounds, assume visible
+    }
+
+    if(to_leaf >= m_size) {
+        return false;
+    }
+
+    if(m_cache.size()) {
+        return m_cache[from_leaf * m_row_words + to_leaf / 64] & (UINT64_C(1) << (to_leaf % 64));
+    }
+
+    // Without the cache we only walk the compressed
+    // row up to the byte that contains the target bit
+    auto target_byte = to_leaf / 8;
+    auto position = static_cast<std::size_t>(m_offsets[from_leaf]);
+    auto byte_index = std::size_t(0);
+
+    while(position < m_data.size()) {
+        auto value = m_data[position++];
+
+        if(value) {
+            if(byte_index == target_byte) {
+                return value & (1U << (to_leaf % 8));
+            }
+
+            byte_index += 1;
+        }
+        else if(position < m_data.size()) {
+            byte_index += m_data[position++];
+
+            if(byte_index > target_byte) {
+                return false;
+            }
+        }
+    }
+
+    return false;
+}
+
+void LevelPVS::decompress_row(std::size_t from_leaf, std::span<std::uint64_t> out_row) const noexcept
+{
+    assert(out_row.size() >= m_row_words);
+
+    std::fill(out_row.begin(), out_row.end(), UINT64_C(0));
+
+    if(from_leaf >= m_size) {
+        return;
+    }
+
+    if(m_cache.size()) {
+        auto cached_row = m_cache.cbegin() + from_leaf * m_row_words;
+        std::copy(cached_row, cached_row + m_row_words, out_row.begin());
+        return;
+    }
+
+    auto row_size = row_bytes(m_size);
+    auto position = static_cast<std::size_t>(m_offsets[from_leaf]);
+    auto byte_index = std::size_t(0);
+
+    while(byte_index < row_size && position < m_data.size()) {
+        auto value = m_data[position++];
+
+        if(value) {
+            out_row[byte_index / 8] |= static_cast<std::uint64_t>(value) << (8 * (byte_index % 8));
+            byte_index += 1;
+        }
+        else if(position < m_data.size()) {
+            byte_index += m_data[position++];
+        }
+    }
+}
+
+void LevelPVS::compress(std::size_t leafcnt, std::span<const std::uint64_t> rows)
+{
+    auto new_row_words = (leafcnt + 63) / 64;
+    auto row_size = row_bytes(leafcnt);
+
+    qf::throw_if<std::invalid_argument>(rows.size() < leafcnt * new_row_words, "visibility matrix is too small");
+
+    clear();
+
+    m_size = leafcnt;
+    m_row_words = new_row_words;
+    m_offsets.reserve(leafcnt);
+
+    for(std::size_t i = 0; i < leafcnt; ++i) {
+        auto row = rows.subspan(i * m_row_words, m_row_words);
+
+        m_offsets.push_back(static_cast<std::uint32_t>(m_data.size()));
+
+        for(std::size_t j = 0; j < row_size; ++j) {
+            auto value = static_cast<std::uint8_t>(row[j / 8] >> (8 * (j % 8)));
+
+            if(value) {
+                m_data.push_back(value);
+                continue;
+            }
+
+            std::size_t run = 1;
+
+            while(j + run < row_size && run < UINT8_MAX && !static_cast<std::uint8_t>(row[(j + run) / 8] >> (8 * ((j + run) % 8)))) {
+                run += 1;
+            }
+
+            m_data.push_back(0);
+            m_data.push_back(static_cast<std::uint8_t>(run));
+
+            j += run - 1;
+        }
+    }
+
+    qf::throw_if<std::overflow_error>(m_data.size() > UINT32_MAX, "compressed visibility data is too big");
+
+    m_data.shrink_to_fit();
+}
+
+void LevelPVS::set_data(std::size_t leafcnt, std::vector<std::uint8_t> data, std::vector<std::uint32_t> offsets)
+{
+    qf::throw_if<std::runtime_error>(offsets.size() != leafcnt, "visibility row count mismatch");
+
+    for(auto offset : offsets) {
+        qf::throw_if<std::runtime_error>(offset > data.size(), "visibility row offset out of bounds");
+    }
+
+    clear();
+
+    m_size = leafcnt;
+    m_row_words = (leafcnt + 63) / 64;
+    m_data = std::move(data);
+    m_offsets = std::move(offsets);
+}
+
+void LevelPVS::select(std::span<const std::uint32_t> indices)
+{
+    for(auto index : indices) {
+        qf::throw_if<std::out_of_range>(index >= m_size, "visibility index out of bounds");
+    }
+
+    auto new_size = indices.size();
+    auto new_row_words = (new_size + 63) / 64;
+
+    std::vector<std::uint64_t> old_row(m_row_words);
+    std::vector<std::uint64_t> new_rows(new_size * new_row_words, UINT64_C(0));
+
+    for(std::size_t i = 0; i < new_size; ++i) {
+        decompress_row(indices[i], old_row);
+
+        auto new_row = &new_rows[i * new_row_words];
+
+        for(std::size_t j = 0; j < new_size; ++j) {
+            if(old_row[indices[j] / 64] & (UINT64_C(1) << (indices[j] % 64))) {
+                new_row[j / 64] |= UINT64_C(1) << (j % 64);
+            }
+        }
+    }
+
+    auto was_cached = is_cached();
+
+    compress(new_size, new_rows);
+    set_cached(was_cached);
+}
+
+void LevelPVS::set_cached(bool enable)
+{
+    if(!enable) {
+        m_cache = std::vector<std::uint64_t>();
+        return;
+    }
+
+    if(m_cache.empty() && m_size) {
+        std::vector<std::uint64_t> new_cache(m_size * m_row_words);
+
+        for(std::size_t i = 0; i < m_size; ++i) {
+            decompress_row(i, std::span(new_cache).subspan(i * m_row_words, m_row_words));
+        }
+
+        m_cache = std::move(new_cache);
+    }
+}
+
+void LevelPVS::clear(void) noexcept
+{
+    m_size = 0;
+    m_row_words = 0;
+    m_data.clear();
+    m_offsets.clear();
+    m_cache.clear();
+}
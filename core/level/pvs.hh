@@ -0,0 +1,89 @@
+#ifndef CORE_LEVEL_PVS_HH
+#define CORE_LEVEL_PVS_HH
+#pragma once
+
+/// Potentially visible set for level leaves; every row is
+/// a bit-packed set of leaves visible from a leaf, compressed
+/// with zero-run encoding (a zero byte is followed by the amount
+/// of zero bytes it stands for) and stored back to back in
+/// a single allocation; rows can be expanded on demand or all
+/// at once into a contiguous cache for constant-time queries
+class LevelPVS final {
+public:
+    constexpr std::size_t size(void) const noexcept;
+    constexpr std::size_t row_words(void) const noexcept;
+    constexpr bool is_cached(void) const noexcept;
+
+    constexpr const std::vector<std::uint8_t>& data(void) const noexcept;
+    constexpr const std::vector<std::uint32_t>& offsets(void) const noexcept;
+
+    /// Checks if a leaf is potentially visible from another leaf
+    /// @param from_leaf Leaf index from which we're looking
+    /// @param to_leaf Leaf index which is to be checked for visibility
+    /// @return True when to_leaf is potentially visible from from_leaf
+    bool is_visible(std::size_t from_leaf, std::size_t to_leaf) const noexcept;
+
+    /// Expands a single compressed row into a bitset
+    /// @param from_leaf Leaf index from which we're looking
+    /// @param out_row Output bitset, must be at least row_words() long
+    void decompress_row(std::size_t from_leaf, std::span<std::uint64_t> out_row) const noexcept;
+
+    /// Compresses an uncompressed visibility matrix
+    /// @param leafcnt Amount of leaves; the matrix is leafcnt by leafcnt bits
+    /// @param rows Bitsets for every leaf, row_words() words each
+    void compress(std::size_t leafcnt, std::span<const std::uint64_t> rows);
+
+    /// Replaces compressed data as-is
+    /// @param leafcnt Amount of leaves
+    /// @param data Compressed rows
+    /// @param offsets Offsets of each row in data
+    /// @throws exceptions if any of the offsets is out of bounds
+    void set_data(std::size_t leafcnt, std::vector<std::uint8_t> data, std::vector<std::uint32_t> offsets);
+
+    /// Keeps only the given rows and columns of the matrix, in the
+    /// given order; used to drop non-leaf entries from legacy data
+    /// @param indices Old indices of the entries to keep
+    /// @throws exceptions if any of the indices is out of bounds
+    void select(std::span<const std::uint32_t> indices);
+
+    /// Expands every row into a contiguous cache; this trades
+    /// leafcnt * leafcnt / 8 bytes of memory for O(1) queries
+    /// @param enable Whether the cache should be present
+    void set_cached(bool enable);
+
+    void clear(void) noexcept;
+
+private:
+    std::size_t m_size { 0 };
+    std::size_t m_row_words { 0 };
+    std::vector<std::uint8_t> m_data;
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<std::uint64_t> m_cache;
+};
+
+constexpr std::size_t LevelPVS::size(void) const noexcept
+{
+    return m_size;
+}
+
+constexpr std::size_t LevelPVS::row_words(void) const noexcept
+{
+    return m_row_words;
+}
+
+constexpr bool LevelPVS::is_cached(void) const noexcept
+{
+    return !m_cache.empty();
+}
+
+constexpr const std::vector<std::uint8_t>& LevelPVS::data(void) const noexcept
+{
+    return m_data;
+}
+
+constexpr const std::vector<std::uint32_t>& LevelPVS::offsets(void) const noexcept
+{
+    return m_offsets;
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "core/pch.hh"
+
+#include "core/level/vertex.hh"
+
+constexpr static float UNORM16_MAX = 65535.0f;
+constexpr static float SNORM16_MAX = 32767.0f;
+
+static float sign_not_zero(float value) noexcept
+{
+    return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+static std::uint16_t encode_unorm16(float value) noexcept
+{
+    // NaN compares false against everything
+    // and thus ends up being encoded as zero
+    value = (value > 0.0f) ? std::min(value, 1.0f) : 0.0f;
+    return static_cast<std::uint16_t>(std::lround(value * UNORM16_MAX));
+}
+
+static float decode_unorm16(std::uint16_t value) noexcept
+{
+    return static_cast<float>(value) / UNORM16_MAX;
+}
+
+static std::int16_t encode_snorm16(float value) noexcept
+{
+    value = std::clamp(value, -1.0f, 1.0f);
+    return static_cast<std::int16_t>(std::lround(value * SNORM16_MAX));
+}
+
+static float decode_snorm16(std::int16_t value) noexcept
+{
+    return std::max(static_cast<float>(value) / SNORM16_MAX, -1.0f);
+}
+
+static void encode_octahedral(const Eigen::Vector3f& vector, std::int16_t out_values[2]) noexcept
+{
+    auto manhattan = std::abs(vector.x()) + std::abs(vector.y()) + std::abs(vector.z());
+
+    if(!(manhattan > 0.0f)) {
+        out_values[0] = 0;
+        out_values[1] = 0;
+        return;
+    }
+
+    auto x = vector.x() / manhattan;
+    auto y = vector.y() / manhattan;
+
+    if(vector.z() < 0.0f) {
+        auto folded_x = (1.0f - std::abs(y)) * sign_not_zero(x);
+        auto folded_y = (1.0f - std::abs(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    out_values[0] = encode_snorm16(x);
+    out_values[1] = encode_snorm16(y);
+}
+
+static Eigen::Vector3f decode_octahedral(const std::int16_t values[2]) noexcept
+{
+    Eigen::Vector3f result;
+    result.x() = decode_snorm16(values[0]);
+    result.y() = decode_snorm16(values[1]);
+    result.z() = 1.0f - std::abs(result.x()) - std::abs(result.y());
+
+    if(result.z() < 0.0f) {
+        auto unfolded_x = (1.0f - std::abs(result.y())) * sign_not_zero(result.x());
+        auto unfolded_y = (1.0f - std::abs(result.x())) * sign_not_zero(result.y());
+        result.x() = unfolded_x;
+        result.y() = unfolded_y;
+    }
+
+    return result.normalized();
+}
+
+PackedLevelVertex pack_level_vertex(const LevelVertex& vertex, const Eigen::AlignedBox3f& bounds) noexcept
+{
+    PackedLevelVertex result;
+
+    Eigen::Vector3f extent(bounds.sizes());
+
+    for(int i = 0; i < 3; ++i) {
+        auto offset = vertex.position[i] - bounds.min()[i];
+        result.position[i] = (extent[i] > 0.0f) ? encode_unorm16(offset / extent[i]) : 0;
+    }
+
+    result.flags = (vertex.tangent.w() < 0.0f) ? PACKED_VERTEX_NEGATIVE_TANGENT : 0;
+
+    encode_octahedral(vertex.normal, result.normal);
+    encode_octahedral(vertex.tangent.head<3>(), result.tangent);
+
+    result.texcoord[0] = std::bit_cast<std::uint16_t>(Eigen::half(vertex.texcoord.x()));
+    result.texcoord[1] = std::bit_cast<std::uint16_t>(Eigen::half(vertex.texcoord.y()));
+
+    result.lightmap[0] = encode_unorm16(vertex.lightmap.x());
+    result.lightmap[1] = encode_unorm16(vertex.lightmap.y());
+
+    return result;
+}
+
+LevelVertex unpack_level_vertex(const PackedLevelVertex& packed, const Eigen::AlignedBox3f& bounds) noexcept
+{
+    LevelVertex result;
+
+    Eigen::Vector3f extent(bounds.sizes());
+
+    for(int i = 0; i < 3; ++i) {
+        result.position[i] = bounds.min()[i] + decode_unorm16(packed.position[i]) * extent[i];
+    }
+
+    result.normal = decode_octahedral(packed.normal);
+
+    auto tangent_sign = (packed.flags & PACKED_VERTEX_NEGATIVE_TANGENT) ? -1.0f : 1.0f;
+    result.tangent << decode_octahedral(packed.tangent), tangent_sign;
+
+    result.texcoord.x() = static_cast<float>(std::bit_cast<Eigen::half>(packed.texcoord[0]));
+    result.texcoord.y() = static_cast<float>(std::bit_cast<Eigen::half>(packed.texcoord[1]));
+
+    result.lightmap.x() = decode_unorm16(packed.lightmap[0]);
+    result.lightmap.y() = decode_unorm16(packed.lightmap[1]);
+
+    return result;
+}
@@ -2,6 +2,10 @@
 #define CORE_LEVEL_VERTEX_HH
 #pragma once
 
+constexpr static std::size_t PACKED_VERTEX_CHUNK = 256; ///< Amount of packed vertices sharing position bounds
+
+constexpr static std::uint16_t PACKED_VERTEX_NEGATIVE_TANGENT = 1 << 0; ///< Tangent W component is negative
+
 struct LevelVertex final {
     Eigen::Vector3f position; ///< Vertex position
     Eigen::Vector3f normal;   ///< Vertex normal
@@ -10,4 +14,31 @@ struct LevelVertex final {
     Eigen::Vector2f lightmap; ///< Lightmap UV
 };
 
+/// Compact vertex layout meant both for storage and for
+/// vertex buffers; positions are quantized within bounds shared
+/// by PACKED_VERTEX_CHUNK consecutive vertices, unit vectors
+/// are octahedral-encoded and texture coordinates are halves
+struct PackedLevelVertex final {
+    std::uint16_t position[3]; ///< Position within chunk bounds, unorm16
+    std::uint16_t flags;       ///< PACKED_VERTEX_* flags
+    std::int16_t normal[2];    ///< Octahedral normal, snorm16
+    std::int16_t tangent[2];   ///< Octahedral tangent, snorm16
+    std::uint16_t texcoord[2]; ///< Color texture UV, half
+    std::uint16_t lightmap[2]; ///< Lightmap UV, unorm16
+};
+
+static_assert(sizeof(PackedLevelVertex) == 12 * sizeof(std::uint16_t));
+
+/// Pack a vertex; the position is expected to be within bounds
+/// @param vertex Vertex to pack
+/// @param bounds Position bounds of the vertex chunk
+/// @return Packed vertex
+PackedLevelVertex pack_level_vertex(const LevelVertex& vertex, const Eigen::AlignedBox3f& bounds) noexcept;
+
+/// Unpack a vertex; the bounds must match the ones used for packing
+/// @param packed Packed vertex
+/// @param bounds Position bounds of the vertex chunk
+/// @return Unpacked vertex
+LevelVertex unpack_level_vertex(const PackedLevelVertex& packed, const Eigen::AlignedBox3f& bounds) noexcept;
+
 #endif
@@ -0,0 +1,187 @@
+#include "core/pch.hh"
+
+#include "core/level/wide_tree.hh"
+
+#include "core/level/level.hh"
+#include "core/utils/simd.hh"
+
+/// Child slot to descend into for every combination of
+/// lanes 0 to 2 being in front of their planes (bit N set
+/// when lane N is); lane 0 picks the pair, lane 1 or 2 the child
+constexpr static std::uint8_t WIDE_CHILD_SLOTS[8] = { 3, 1, 3, 0, 2, 1, 2, 0 };
+
+LevelWideTree::LevelWideTree(void) noexcept
+{
+    clear();
+}
+
+void LevelWideTree::build(const Level& level)
+{
+    const auto& flat_nodes = level.nodes();
+
+    std::vector<WideNode> nodes;
+    nodes.reserve(flat_nodes.size() / 3 + 1);
+
+    // Lanes with no plane to test still have to
+    // lead somewhere; a plane with a zero normal and
+    // a positive offset has everything in front of it
+    auto set_lane = [&level](WideNode& node, std::size_t lane, std::int32_t flat_node) {
+        if(flat_node >= 0) {
+            const auto plane = level.plane(static_cast<std::size_t>(flat_node));
+            node.plane_x[lane] = plane.coeffs()[0];
+            node.plane_y[lane] = plane.coeffs()[1];
+            node.plane_z[lane] = plane.coeffs()[2];
+            node.plane_d[lane] = plane.coeffs()[3];
+        }
+        else {
+            node.plane_x[lane] = 0.0f;
+            node.plane_y[lane] = 0.0f;
+            node.plane_z[lane] = 0.0f;
+            node.plane_d[lane] = 1.0f;
+        }
+    };
+
+    struct PendingNode final {
+        std::int32_t flat_node;
+        std::int32_t parent;
+        std::size_t slot;
+    };
+
+    auto root_node = level.root_node();
+
+    std::vector<PendingNode> stack;
+
+    if(root_node >= 0) {
+        stack.push_back(PendingNode { root_node, -1, 0 });
+    }
+
+    while(!stack.empty()) {
+        auto pending = stack.back();
+        stack.pop_back();
+
+        auto node_index = static_cast<std::int32_t>(nodes.size());
+
+        if(pending.parent >= 0) {
+            nodes[pending.parent].children[pending.slot] = node_index;
+        }
+        else {
+            root_node = node_index;
+        }
+
+        const auto& flat = flat_nodes[pending.flat_node];
+
+        WideNode node;
+        set_lane(node, 0, pending.flat_node);
+        set_lane(node, 1, flat.children[0]);
+        set_lane(node, 2, flat.children[1]);
+        set_lane(node, 3, -1);
+
+        std::int32_t grandchildren[WIDE_NODE_LANES];
+
+        for(std::size_t i = 0; i < 2; ++i) {
+            auto child = flat.children[i];
+
+            if(child >= 0) {
+                grandchildren[2 * i + 0] = flat_nodes[child].children[0];
+                grandchildren[2 * i + 1] = flat_nodes[child].children[1];
+            }
+            else {
+                grandchildren[2 * i + 0] = child;
+                grandchildren[2 * i + 1] = child;
+            }
+        }
+
+        nodes.push_back(node);
+
+        // Pushed backwards so that the first
+        // child ends up right after its parent
+        for(auto slot = WIDE_NODE_LANES; slot-- > 0;) {
+            nodes[node_index].children[slot] = grandchildren[slot];
+
+            if(grandchildren[slot] >= 0) {
+                stack.push_back(PendingNode { grandchildren[slot], node_index, slot });
+            }
+        }
+    }
+
+    m_nodes = std::move(nodes);
+    m_root_node = root_node;
+}
+
+void LevelWideTree::clear(void) noexcept
+{
+    m_nodes.clear();
+    m_root_node = LEVEL_CHILD_NONE;
+}
+
+std::int32_t LevelWideTree::find_leaf_index(const Eigen::Vector3f& position) const noexcept
+{
+    assert(position.allFinite());
+
+    auto child = m_root_node;
+
+    // Distances are summed up in the same order as the binary
+    // tree does it; axial planes have zeros in the other lanes,
+    // which add nothing, so the result is exactly the same
+#if defined(CORE_SIMD_SSE2)
+    auto position_x = _mm_set1_ps(position.x());
+    auto position_y = _mm_set1_ps(position.y());
+    auto position_z = _mm_set1_ps(position.z());
+    auto zero = _mm_setzero_ps();
+
+    while(child >= 0) {
+        const auto& node = m_nodes[child];
+
+        auto distance = _mm_mul_ps(_mm_load_ps(node.plane_x), position_x);
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(node.plane_y), position_y));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(node.plane_z), position_z));
+        distance = _mm_add_ps(distance, _mm_load_ps(node.plane_d));
+
+        auto front_mask = _mm_movemask_ps(_mm_cmpge_ps(distance, zero));
+
+        child = node.children[WIDE_CHILD_SLOTS[front_mask & 7]];
+    }
+#elif defined(CORE_SIMD_NEON)
+    auto position_x = vdupq_n_f32(position.x());
+    auto position_y = vdupq_n_f32(position.y());
+    auto position_z = vdupq_n_f32(position.z());
+    auto zero = vdupq_n_f32(0.0f);
+
+    while(child >= 0) {
+        const auto& node = m_nodes[child];
+
+        // Multiplies and adds are kept apart on purpose;
+        // a fused multiply-add would round differently
+        auto distance = vmulq_f32(vld1q_f32(node.plane_x), position_x);
+        distance = vaddq_f32(distance, vmulq_f32(vld1q_f32(node.plane_y), position_y));
+        distance = vaddq_f32(distance, vmulq_f32(vld1q_f32(node.plane_z), position_z));
+        distance = vaddq_f32(distance, vld1q_f32(node.plane_d));
+
+        auto front = vcgeq_f32(distance, zero);
+        auto front_mask = (vgetq_lane_u32(front, 0) & 1U) | (vgetq_lane_u32(front, 1) & 2U) | (vgetq_lane_u32(front, 2) & 4U);
+
+        child = node.children[WIDE_CHILD_SLOTS[front_mask]];
+    }
+#else
+    while(child >= 0) {
+        const auto& node = m_nodes[child];
+
+        unsigned int front_mask = 0;
+
+        for(std::size_t i = 0; i < 3; ++i) {
+            auto distance = node.plane_x[i] * position.x();
+            distance += node.plane_y[i] * position.y();
+            distance += node.plane_z[i] * position.z();
+            distance += node.plane_d[i];
+
+            if(distance >= 0.0f) {
+                front_mask |= 1U << i;
+            }
+        }
+
+        child = node.children[WIDE_CHILD_SLOTS[front_mask]];
+    }
+#endif
+
+    return (child == LEVEL_CHILD_NONE) ? -1 : ~child;
+}
@@ -0,0 +1,66 @@
+#ifndef CORE_LEVEL_WIDE_TREE_HH
+#define CORE_LEVEL_WIDE_TREE_HH
+#pragma once
+
+constexpr static std::size_t WIDE_NODE_LANES = 4;
+
+class Level;
+
+/// Level tree with every two levels collapsed into a single node;
+/// a wide node holds the plane of a binary node and the planes of
+/// both its children, all of which are tested at once, so point
+/// location takes half as many dependent node fetches; child
+/// references follow the same convention as Level::FlatNode
+class LevelWideTree final {
+public:
+    /// Node planes are laid out one lane per plane; lane 0 is
+    /// the topmost plane, lanes 1 and 2 are its front and back
+    /// children and lane 3 is padding; children 0 and 1 are
+    /// in front of lane 0, children 2 and 3 are behind it
+    struct alignas(16) WideNode final {
+        float plane_x[WIDE_NODE_LANES];
+        float plane_y[WIDE_NODE_LANES];
+        float plane_z[WIDE_NODE_LANES];
+        float plane_d[WIDE_NODE_LANES];
+        std::int32_t children[WIDE_NODE_LANES];
+    };
+
+    LevelWideTree(void) noexcept;
+
+    constexpr bool empty(void) const noexcept;
+    constexpr std::int32_t root_node(void) const noexcept;
+    constexpr const std::vector<WideNode>& nodes(void) const noexcept;
+
+    /// Collapse the tree of a level
+    /// @param level Level to collapse the tree of
+    void build(const Level& level);
+
+    void clear(void) noexcept;
+
+    /// Locate a leaf index in which a point is located; the
+    /// result is exactly the same as walking the binary tree
+    /// @param position Position to locate leaf for
+    /// @return Leaf index or -1 if not found
+    std::int32_t find_leaf_index(const Eigen::Vector3f& position) const noexcept;
+
+private:
+    std::vector<WideNode> m_nodes;
+    std::int32_t m_root_node;
+};
+
+constexpr bool LevelWideTree::empty(void) const noexcept
+{
+    return m_nodes.empty();
+}
+
+constexpr std::int32_t LevelWideTree::root_node(void) const noexcept
+{
+    return m_root_node;
+}
+
+constexpr const std::vector<LevelWideTree::WideNode>& LevelWideTree::nodes(void) const noexcept
+{
+    return m_nodes;
+}
+
+#endif
@@ -0,0 +1,202 @@
+#include "core/pch.hh"
+
+#include "core/mapped_file.hh"
+
+#include "core/exceptions.hh"
+#include "core/utils/physfs.hh"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(std::string_view path)
+{
+    open(path);
+}
+
+MappedFile::~MappedFile(void)
+{
+    close();
+}
+
+std::size_t MappedFile::size(void) const
+{
+    return m_size;
+}
+
+const std::byte* MappedFile::data(void) const
+{
+    return m_data;
+}
+
+void MappedFile::open(std::string_view path)
+{
+    close();
+
+    auto path_unfucked = std::string(path);
+    auto realdir = PHYSFS_getRealDir(path_unfucked.c_str());
+
+    qf::throw_if_not_fmt<std::runtime_error>(realdir, "{}: {}", path_unfucked, utils::physfs_error());
+
+    std::error_code ec;
+    std::filesystem::path realdir_path(realdir);
+
+    if(std::filesystem::is_directory(realdir_path, ec)) {
+        // The file is backed by a plain directory on the host
+        // filesystem; PhysFS paths are always slash-separated and
+        // relative to the mount point, so we can just glue them together
+        if(map_native(realdir_path / std::filesystem::path(path_unfucked).relative_path())) {
+            return;
+        }
+    }
+
+    // The file lives inside of an archive or mapping failed
+    // for whatever reason; fall back to reading the whole thing
+    // into memory once and serving views into that copy instead
+    auto file = PHYSFS_openRead(path_unfucked.c_str());
+    qf::throw_if_not_fmt<std::runtime_error>(file, "{}: {}", path_unfucked, utils::physfs_error());
+
+    auto length = PHYSFS_fileLength(file);
+
+    if(length < 0) {
+        PHYSFS_close(file);
+        throw qf::runtime_error("{}: unable to determine file length", path_unfucked);
+    }
+
+    m_vector.resize(static_cast<std::size_t>(length));
+
+    auto length_read = PHYSFS_readBytes(file, m_vector.data(), m_vector.size());
+    PHYSFS_close(file);
+
+    if(length_read != length) {
+        m_vector.clear();
+        throw qf::runtime_error("{}: short read: {}", path_unfucked, utils::physfs_error());
+    }
+
+    m_data = m_vector.data();
+    m_size = m_vector.size();
+}
+
+#if defined(_WIN32)
+
+void MappedFile::close(void) noexcept
+{
+    if(m_is_mapped) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(reinterpret_cast<HANDLE>(m_mapping_handle));
+        CloseHandle(reinterpret_cast<HANDLE>(m_file_handle));
+
+        m_mapping_handle = nullptr;
+        m_file_handle = nullptr;
+    }
+
+    m_vector.clear();
+    m_vector.shrink_to_fit();
+
+    m_data = nullptr;
+    m_size = 0;
+    m_is_mapped = false;
+}
+
+bool MappedFile::map_native(const std::filesystem::path& native_path)
+{
+    auto file_handle = CreateFileW(native_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if(file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER length;
+
+    if(!GetFileSizeEx(file_handle, &length) || length.QuadPart <= 0) {
+        // Zero-length files cannot be mapped; the fallback
+        // path handles them just fine, so we let it do the work
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    auto mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if(mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    auto view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+
+    if(view == nullptr) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    m_file_handle = file_handle;
+    m_mapping_handle = mapping_handle;
+
+    m_data = reinterpret_cast<const std::byte*>(view);
+    m_size = static_cast<std::size_t>(length.QuadPart);
+    m_is_mapped = true;
+
+    return true;
+}
+
+#else
+
+void MappedFile::close(void) noexcept
+{
+    if(m_is_mapped) {
+        munmap(const_cast<std::byte*>(m_data), m_size);
+    }
+
+    m_vector.clear();
+    m_vector.shrink_to_fit();
+
+    m_data = nullptr;
+    m_size = 0;
+    m_is_mapped = false;
+}
+
+bool MappedFile::map_native(const std::filesystem::path& native_path)
+{
+    auto fd = ::open(native_path.c_str(), O_RDONLY);
+
+    if(fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+
+    if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        // Zero-length files cannot be mapped; the fallback
+        // path handles them just fine, so we let it do the work
+        ::close(fd);
+        return false;
+    }
+
+    auto view = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping holds its own reference to the
+    // file, so the descriptor is not needed anymore
+    ::close(fd);
+
+    if(view == MAP_FAILED) {
+        return false;
+    }
+
+    madvise(view, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    m_data = reinterpret_cast<const std::byte*>(view);
+    m_size = static_cast<std::size_t>(st.st_size);
+    m_is_mapped = true;
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef CORE_MAPPED_FILE_HH
+#define CORE_MAPPED_FILE_HH
+#pragma once
+
+/// A read-only view of a whole file's contents; files that
+/// PhysFS resolves into a native directory are memory-mapped
+/// directly, files that live inside archives are read into
+/// an owned buffer with a single PHYSFS_readBytes call instead
+class MappedFile final {
+public:
+    MappedFile(void) = default;
+    explicit MappedFile(std::string_view path);
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+    virtual ~MappedFile(void);
+
+    std::size_t size(void) const;
+    const std::byte* data(void) const;
+
+    constexpr bool is_mapped(void) const noexcept;
+
+    /// Open a file and expose its contents
+    /// @param path PhysFS path to the file
+    /// @throws exceptions if anything bad happens
+    void open(std::string_view path);
+
+    /// Unmap or release file contents; any views
+    /// into the file's contents become invalid
+    void close(void) noexcept;
+
+private:
+    bool map_native(const std::filesystem::path& native_path);
+
+    std::vector<std::byte> m_vector;
+    const std::byte* m_data { nullptr };
+    std::size_t m_size { 0 };
+    bool m_is_mapped { false };
+
+#if defined(_WIN32)
+    void* m_file_handle { nullptr };
+    void* m_mapping_handle { nullptr };
+#endif
+};
+
+constexpr bool MappedFile::is_mapped(void) const noexcept
+{
+    return m_is_mapped;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#include "core/pch.hh"
+
+#include "core/math/frustum.hh"
+
+#include "core/math/plane.hh"
+
+math::Frustum::Frustum(const Eigen::Matrix4f& view_projection) noexcept
+{
+    set(view_projection);
+}
+
+void math::Frustum::set(const Eigen::Matrix4f& view_projection) noexcept
+{
+    // Gribb-Hartmann extraction; a clip-space point is inside
+    // the view volume when -w <= x, y, z <= w, every inequality
+    // turns into a plane once the matrix rows are substituted
+    const Eigen::RowVector4f row_w = view_projection.row(3);
+    const Eigen::RowVector4f rows[FRUSTUM_PLANE_COUNT] = {
+        row_w + view_projection.row(0), // left
+        row_w - view_projection.row(0), // right
+        row_w + view_projection.row(1), // bottom
+        row_w - view_projection.row(1), // top
+        row_w + view_projection.row(2), // near
+        row_w - view_projection.row(2), // far
+    };
+
+    for(std::size_t i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        m_planes[i].coeffs() = rows[i].transpose();
+        m_planes[i].normalize();
+
+        m_plane_types[i] = math::plane_type(m_planes[i].normal());
+        m_plane_signbits[i] = math::plane_signbits(m_planes[i].normal());
+    }
+}
+
+bool math::Frustum::cull_box(const Eigen::AlignedBox3f& box, unsigned int& plane_mask) const noexcept
+{
+    if(box.isEmpty()) {
+        return true;
+    }
+
+    for(std::size_t i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        if(plane_mask & (1U << i)) {
+            auto& plane = m_planes[i];
+            auto sides = math::box_on_plane_side(box.min(), box.max(), plane.normal(), plane.offset(), m_plane_types[i],
+                m_plane_signbits[i]);
+
+            if(sides == PLANE_SIDE_BACK) {
+                return true;
+            }
+
+            if(sides == PLANE_SIDE_FRONT) {
+                plane_mask &= ~(1U << i);
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,43 @@
+#ifndef CORE_MATH_FRUSTUM_HH
+#define CORE_MATH_FRUSTUM_HH
+#pragma once
+
+constexpr static std::size_t FRUSTUM_PLANE_COUNT = 6;
+constexpr static unsigned int FRUSTUM_ALL_PLANES = (1U << FRUSTUM_PLANE_COUNT) - 1U;
+
+namespace math
+{
+/// Six clipping planes of a view volume; normals point
+/// inwards so that points inside are in front of every plane
+class Frustum final {
+public:
+    Frustum(void) = default;
+    explicit Frustum(const Eigen::Matrix4f& view_projection) noexcept;
+
+    constexpr const std::array<Eigen::Hyperplane<float, 3>, FRUSTUM_PLANE_COUNT>& planes(void) const noexcept;
+
+    /// Extract planes from a clip-space transform
+    /// @param view_projection Matrix that maps world space into OpenGL clip space
+    void set(const Eigen::Matrix4f& view_projection) noexcept;
+
+    /// Test a box against the planes that are still set in a
+    /// mask; planes the box is entirely in front of are cleared
+    /// from the mask so nothing inside the box tests them again
+    /// @param box Box to test
+    /// @param plane_mask Planes to test, bit N stands for plane N
+    /// @return True if the box is entirely outside the frustum
+    bool cull_box(const Eigen::AlignedBox3f& box, unsigned int& plane_mask) const noexcept;
+
+private:
+    std::array<Eigen::Hyperplane<float, 3>, FRUSTUM_PLANE_COUNT> m_planes;
+    std::array<std::uint8_t, FRUSTUM_PLANE_COUNT> m_plane_types {};
+    std::array<std::uint8_t, FRUSTUM_PLANE_COUNT> m_plane_signbits {};
+};
+} // namespace math
+
+constexpr const std::array<Eigen::Hyperplane<float, 3>, FRUSTUM_PLANE_COUNT>& math::Frustum::planes(void) const noexcept
+{
+    return m_planes;
+}
+
+#endif
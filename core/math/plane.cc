@@ -0,0 +1,74 @@
+#include "core/pch.hh"
+
+#include "core/math/plane.hh"
+
+std::uint8_t math::plane_type(const Eigen::Vector3f& normal) noexcept
+{
+    if(std::abs(normal.x()) == 1.0f && normal.y() == 0.0f && normal.z() == 0.0f) {
+        return PLANE_X;
+    }
+
+    if(std::abs(normal.y()) == 1.0f && normal.x() == 0.0f && normal.z() == 0.0f) {
+        return PLANE_Y;
+    }
+
+    if(std::abs(normal.z()) == 1.0f && normal.x() == 0.0f && normal.y() == 0.0f) {
+        return PLANE_Z;
+    }
+
+    return PLANE_ANY;
+}
+
+std::uint8_t math::plane_signbits(const Eigen::Vector3f& normal) noexcept
+{
+    std::uint8_t result = 0;
+
+    for(int i = 0; i < 3; ++i) {
+        if(normal[i] < 0.0f) {
+            result |= static_cast<std::uint8_t>(1 << i);
+        }
+    }
+
+    return result;
+}
+
+unsigned int math::box_on_plane_side(const Eigen::Vector3f& mins, const Eigen::Vector3f& maxs, const Eigen::Vector3f& normal, float offset,
+    std::uint8_t type, std::uint8_t signbits) noexcept
+{
+    float near_distance;
+    float far_distance;
+
+    if(type < PLANE_ANY) {
+        auto min_distance = normal[type] * mins[type] + offset;
+        auto max_distance = normal[type] * maxs[type] + offset;
+        near_distance = std::min(min_distance, max_distance);
+        far_distance = std::max(min_distance, max_distance);
+    }
+    else {
+        // Sign bits pick the corner that lies the farthest
+        // along the normal and the one opposite to it
+        Eigen::Vector3f far_corner;
+        Eigen::Vector3f near_corner;
+
+        for(int i = 0; i < 3; ++i) {
+            auto negative = signbits & (1 << i);
+            far_corner[i] = negative ? mins[i] : maxs[i];
+            near_corner[i] = negative ? maxs[i] : mins[i];
+        }
+
+        near_distance = normal.dot(near_corner) + offset;
+        far_distance = normal.dot(far_corner) + offset;
+    }
+
+    unsigned int sides = 0;
+
+    if(far_distance >= 0.0f) {
+        sides |= PLANE_SIDE_FRONT;
+    }
+
+    if(near_distance < 0.0f) {
+        sides |= PLANE_SIDE_BACK;
+    }
+
+    return sides;
+}
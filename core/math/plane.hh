@@ -0,0 +1,58 @@
+#ifndef CORE_MATH_PLANE_HH
+#define CORE_MATH_PLANE_HH
+#pragma once
+
+constexpr static std::uint8_t PLANE_X = 0;   ///< Normal is parallel to the X axis
+constexpr static std::uint8_t PLANE_Y = 1;   ///< Normal is parallel to the Y axis
+constexpr static std::uint8_t PLANE_Z = 2;   ///< Normal is parallel to the Z axis
+constexpr static std::uint8_t PLANE_ANY = 3; ///< Normal is not axis-aligned
+
+constexpr static unsigned int PLANE_SIDE_FRONT = 1 << 0; ///< Some of the box is in front of the plane
+constexpr static unsigned int PLANE_SIDE_BACK = 1 << 1;  ///< Some of the box is behind the plane
+constexpr static unsigned int PLANE_SIDE_BOTH = PLANE_SIDE_FRONT | PLANE_SIDE_BACK;
+
+namespace math
+{
+/// Classify a plane by its normal; axial planes
+/// are tested against with a single component
+/// @param normal Plane normal
+/// @return One of PLANE_* types
+std::uint8_t plane_type(const Eigen::Vector3f& normal) noexcept;
+
+/// Pack signs of a plane normal; bit N is set when
+/// component N of the normal is negative, which tells
+/// which box corners are the nearest and the farthest
+/// @param normal Plane normal
+/// @return Sign bits of the normal
+std::uint8_t plane_signbits(const Eigen::Vector3f& normal) noexcept;
+
+/// Signed distance from a plane to a point
+/// @param normal Plane normal
+/// @param offset Plane offset, the distance is normal.dot(point) + offset
+/// @param type Plane type as returned by plane_type
+/// @param point Point to measure the distance to
+/// @return Signed distance, positive in front of the plane
+inline float plane_distance(const Eigen::Vector3f& normal, float offset, std::uint8_t type, const Eigen::Vector3f& point) noexcept;
+
+/// Classify a box against a plane
+/// @param mins Box minimum corner
+/// @param maxs Box maximum corner
+/// @param normal Plane normal
+/// @param offset Plane offset
+/// @param type Plane type as returned by plane_type
+/// @param signbits Sign bits as returned by plane_signbits
+/// @return PLANE_SIDE_* flags
+unsigned int box_on_plane_side(const Eigen::Vector3f& mins, const Eigen::Vector3f& maxs, const Eigen::Vector3f& normal, float offset,
+    std::uint8_t type, std::uint8_t signbits) noexcept;
+} // namespace math
+
+inline float math::plane_distance(const Eigen::Vector3f& normal, float offset, std::uint8_t type, const Eigen::Vector3f& point) noexcept
+{
+    if(type < PLANE_ANY) {
+        return normal[type] * point[type] + offset;
+    }
+
+    return normal.dot(point) + offset;
+}
+
+#endif
@@ -9,13 +9,20 @@
 #include <cstdarg>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <chrono>
 #include <concepts>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <format>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <mutex>
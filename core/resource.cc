@@ -2,20 +2,102 @@
 
 #include "core/resource.hh"
 
+#include "core/jobs.hh"
+#include "core/utils/epoch.hh"
+
 struct Loader final {
     res::load_func load_fn;
+    res::finalize_func finalize_fn;
     res::free_func free_fn;
 
     std::unordered_map<std::string, res::handle<void>> resources;
 
+    // Requests that are still being loaded; a request for
+    // a name that is already in here gets merged into it
+    std::unordered_map<std::string, std::shared_ptr<res::detail::AsyncRequest>> requests;
+
     std::vector<res::handle<void>> cache;
 
     std::string classname;
 };
 
+struct res::detail::AsyncRequest final {
+    Loader* loader;
+    std::string name;
+    std::uint32_t flags;
+
+    // Worker threads only ever touch the prepared data
+    // and the counter; everything else is main thread only
+    jobs::Counter counter;
+    const void* prepared { nullptr };
+
+    bool is_cached { false };
+    bool is_ready { false };
+    res::handle<void> resource;
+};
+
 static std::unordered_map<std::type_index, std::unique_ptr<Loader>> s_loaders;
 
-void res::detail::register_loader(const std::type_info& type, load_func load_fn, free_func free_fn)
+/// Requests that are still being loaded in the
+/// order they were made, so that res::pump finalizes
+/// the ones that were asked for earlier first
+static std::vector<std::shared_ptr<res::detail::AsyncRequest>> s_requests;
+
+static const void* finalize_resource(const Loader& loader, const std::string& name, std::uint32_t flags, const void* prepared)
+{
+    if(loader.finalize_fn && prepared) {
+        return loader.finalize_fn(name.c_str(), flags, prepared);
+    }
+
+    return prepared;
+}
+
+static res::handle<void> store_resource(Loader& loader, const std::string& name, const void* raw, bool is_cached)
+{
+    res::handle<void> resource(raw, [](const void* ptr) { /* empty */ });
+
+    auto loaded = loader.resources.insert_or_assign(name, std::move(resource));
+
+    if(is_cached) {
+        loader.cache.push_back(loaded.first->second);
+    }
+
+    return loaded.first->second;
+}
+
+static void complete_request(res::detail::AsyncRequest& request)
+{
+    assert(request.counter.is_done());
+    assert(!request.is_ready);
+
+    auto loader = request.loader;
+    auto raw = finalize_resource(*loader, request.name, request.flags, request.prepared);
+
+    request.prepared = nullptr;
+    request.is_ready = true;
+
+    if(raw == nullptr) {
+        LOG_WARNING("{}<{}>: load failed", request.name, loader->classname);
+    }
+    else {
+        request.resource = store_resource(*loader, request.name, raw, request.is_cached);
+    }
+
+    loader->requests.erase(request.name);
+}
+
+static void remove_request(const res::detail::AsyncRequest& request)
+{
+    auto iter = std::find_if(s_requests.cbegin(), s_requests.cend(), [&request](const auto& pending) {
+        return pending.get() == &request;
+    });
+
+    if(iter != s_requests.cend()) {
+        s_requests.erase(iter);
+    }
+}
+
+void res::detail::register_loader(const std::type_info& type, load_func load_fn, finalize_func finalize_fn, free_func free_fn)
 {
     assert(load_fn);
     assert(free_fn);
@@ -23,6 +105,7 @@ void res::detail::register_loader(const std::type_info& type, load_func load_fn,
     auto loader = std::make_unique<Loader>();
     loader->classname = type.name();
     loader->load_fn = load_fn;
+    loader->finalize_fn = finalize_fn;
     loader->free_fn = free_fn;
 
     std::type_index type_index(type);
@@ -49,25 +132,90 @@ res::handle<void> res::detail::load_resource(const std::type_info& type, std::st
     auto found = loader->second->resources.find(name_unfucked);
 
     if(found == loader->second->resources.cend()) {
-        auto raw = loader->second->load_fn(name_unfucked.c_str(), flags);
+        auto request = loader->second->requests.find(name_unfucked);
+
+        if(request != loader->second->requests.cend()) {
+            // The resource is already being loaded in the
+            // background; waiting for it and finalizing it
+            // right away is cheaper than loading it twice
+            auto pending = request->second;
+            pending->is_cached = pending->is_cached || (flags & RESFLAG_CACHE);
+
+            jobs::wait(pending->counter);
+
+            complete_request(*pending);
+            remove_request(*pending);
+
+            return pending->resource;
+        }
+
+        auto prepared = loader->second->load_fn(name_unfucked.c_str(), flags);
+        auto raw = finalize_resource(*loader->second, name_unfucked, flags, prepared);
 
         if(raw == nullptr) {
             LOG_WARNING("{}<{}>: load failed", name_unfucked, type.name());
             return nullptr;
         }
 
-        handle<void> resource(raw, [](const void* ptr) { /* empty */ });
+        return store_resource(*loader->second, name_unfucked, raw, flags & RESFLAG_CACHE);
+    }
 
-        auto loaded = loader->second->resources.insert_or_assign(name_unfucked, std::move(resource));
+    return found->second;
+}
 
-        if(flags & RESFLAG_CACHE) {
-            loader->second->cache.push_back(loaded.first->second);
-        }
+std::shared_ptr<res::detail::AsyncRequest> res::detail::load_resource_async(const std::type_info& type, std::string_view name,
+    std::uint32_t flags)
+{
+    std::string name_unfucked(name);
+    std::type_index type_index(type);
+
+    auto loader = s_loaders.find(type_index);
+
+    if(loader == s_loaders.cend()) {
+        LOG_WARNING("no loader present for <{}>", type.name());
 
-        return loaded.first->second;
+        auto failed = std::make_shared<AsyncRequest>();
+        failed->is_ready = true;
+        return failed;
     }
 
-    return found->second;
+    auto found = loader->second->resources.find(name_unfucked);
+
+    if(found != loader->second->resources.cend()) {
+        auto loaded = std::make_shared<AsyncRequest>();
+        loaded->is_ready = true;
+        loaded->resource = found->second;
+        return loaded;
+    }
+
+    auto request = loader->second->requests.find(name_unfucked);
+
+    if(request != loader->second->requests.cend()) {
+        request->second->is_cached = request->second->is_cached || (flags & RESFLAG_CACHE);
+        return request->second;
+    }
+
+    auto pending = std::make_shared<AsyncRequest>();
+    pending->loader = loader->second.get();
+    pending->name = name_unfucked;
+    pending->flags = flags;
+    pending->is_cached = flags & RESFLAG_CACHE;
+
+    loader->second->requests.insert_or_assign(name_unfucked, pending);
+    s_requests.push_back(pending);
+
+    // The request outlives the job because it's only
+    // let go of after its counter has dropped to zero
+    jobs::submit([request = pending.get(), load_fn = loader->second->load_fn] {
+        try {
+            request->prepared = load_fn(request->name.c_str(), request->flags);
+        }
+        catch(const std::exception& ex) {
+            LOG_WARNING("{}: {}", request->name, ex.what());
+        }
+    }, &pending->counter);
+
+    return pending;
 }
 
 res::handle<void> res::detail::find_resource(const std::type_info& type, std::string_view name)
@@ -92,6 +240,41 @@ res::handle<void> res::detail::find_resource(const std::type_info& type, std::st
     return found->second;
 }
 
+bool res::detail::is_request_ready(const AsyncRequest& request)
+{
+    return request.is_ready;
+}
+
+res::handle<void> res::detail::request_resource(const AsyncRequest& request)
+{
+    return request.resource;
+}
+
+void res::pump(std::uint64_t budget_us)
+{
+    auto start_us = utils::epoch_microseconds();
+    std::size_t index = 0;
+
+    // A request is taken out of the list before it's finalized;
+    // finalize functions may load other resources, which adds to
+    // and removes from s_requests, so iterators wouldn't survive
+    while(index < s_requests.size()) {
+        if(!s_requests[index]->counter.is_done()) {
+            index += 1;
+            continue;
+        }
+
+        auto request = std::move(s_requests[index]);
+        s_requests.erase(s_requests.begin() + index);
+
+        complete_request(*request);
+
+        if(utils::epoch_microseconds() - start_us >= budget_us) {
+            break;
+        }
+    }
+}
+
 void res::soft_purge(bool include_cached)
 {
     for(auto& [type_index, loader] : s_loaders) {
@@ -125,6 +308,16 @@ void res::soft_purge(bool include_cached)
 
 void res::hard_purge(void)
 {
+    // Requests still in flight are finished first
+    // so that whatever they load is released as well
+    while(!s_requests.empty()) {
+        auto request = std::move(s_requests.front());
+        s_requests.erase(s_requests.begin());
+
+        jobs::wait(request->counter);
+        complete_request(*request);
+    }
+
     for(auto& [type_index, loader] : s_loaders) {
         loader->cache.clear();
 
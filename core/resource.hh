@@ -13,15 +13,54 @@ using handle = std::shared_ptr<const T>;
 
 namespace res
 {
+/// Loads a resource; with a finalize function present it only
+/// loads intermediate data that is handed over to finalize later.
+/// Either way it may be called from worker threads by load_async
 using load_func = const void* (*)(const char* name, std::uint32_t flags);
+/// Turns intermediate data into a resource on the main thread and
+/// takes ownership of the intermediate data regardless of success
+using finalize_func = const void* (*)(const char* name, std::uint32_t flags, const void* prepared);
 using free_func = void (*)(const void* resource);
 } // namespace res
 
 namespace res::detail
 {
-void register_loader(const std::type_info& type, load_func load_fn, free_func free_fn);
+struct AsyncRequest;
+} // namespace res::detail
+
+namespace res
+{
+/// Resource that is being loaded in the background;
+/// it becomes ready once res::pump finalizes it
+template<typename T>
+class async_handle final {
+public:
+    async_handle(void) = default;
+    explicit async_handle(std::shared_ptr<detail::AsyncRequest> request);
+
+    /// @return True if loading has finished, successfully or not
+    bool is_ready(void) const;
+
+    /// @return Loaded resource or nullptr if it's not ready or has failed to load
+    handle<T> get(void) const;
+
+    /// Let go of the request; the resource is still
+    /// loaded in the background if anybody else wants it
+    void reset(void);
+
+private:
+    std::shared_ptr<detail::AsyncRequest> m_request;
+};
+} // namespace res
+
+namespace res::detail
+{
+void register_loader(const std::type_info& type, load_func load_fn, finalize_func finalize_fn, free_func free_fn);
 handle<void> load_resource(const std::type_info& type, std::string_view name, std::uint32_t flags);
+std::shared_ptr<AsyncRequest> load_resource_async(const std::type_info& type, std::string_view name, std::uint32_t flags);
 handle<void> find_resource(const std::type_info& type, std::string_view name);
+bool is_request_ready(const AsyncRequest& request);
+handle<void> request_resource(const AsyncRequest& request);
 } // namespace res::detail
 
 namespace res
@@ -29,21 +68,68 @@ namespace res
 template<typename T>
 void register_loader(load_func load_fn, free_func free_fn);
 template<typename T>
+void register_loader(load_func load_fn, finalize_func finalize_fn, free_func free_fn);
+template<typename T>
 handle<T> load(std::string_view name, std::uint32_t flags = 0);
 template<typename T>
+async_handle<T> load_async(std::string_view name, std::uint32_t flags = 0);
+template<typename T>
 handle<T> find(std::string_view name);
 } // namespace res
 
+namespace res
+{
+/// Finalize resources that have finished loading in the
+/// background; at least one is finalized per call if there
+/// are any, the rest only as long as the time budget allows
+/// @param budget_us Time budget in microseconds
+void pump(std::uint64_t budget_us);
+} // namespace res
+
 namespace res
 {
 void soft_purge(bool include_cached = false);
 void hard_purge(void);
 } // namespace res
 
+template<typename T>
+res::async_handle<T>::async_handle(std::shared_ptr<detail::AsyncRequest> request) : m_request(std::move(request))
+{
+}
+
+template<typename T>
+bool res::async_handle<T>::is_ready(void) const
+{
+    return m_request && res::detail::is_request_ready(*m_request);
+}
+
+template<typename T>
+res::handle<T> res::async_handle<T>::get(void) const
+{
+    if(m_request == nullptr) {
+        return nullptr;
+    }
+
+    auto result = res::detail::request_resource(*m_request);
+    return std::reinterpret_pointer_cast<const T>(result);
+}
+
+template<typename T>
+void res::async_handle<T>::reset(void)
+{
+    m_request.reset();
+}
+
 template<typename T>
 void res::register_loader(load_func load_fn, free_func free_fn)
 {
-    res::detail::register_loader(typeid(T), load_fn, free_fn);
+    res::detail::register_loader(typeid(T), load_fn, nullptr, free_fn);
+}
+
+template<typename T>
+void res::register_loader(load_func load_fn, finalize_func finalize_fn, free_func free_fn)
+{
+    res::detail::register_loader(typeid(T), load_fn, finalize_fn, free_fn);
 }
 
 template<typename T>
@@ -53,6 +139,12 @@ res::handle<T> res::load(std::string_view name, std::uint32_t flags)
     return std::reinterpret_pointer_cast<const T>(result);
 }
 
+template<typename T>
+res::async_handle<T> res::load_async(std::string_view name, std::uint32_t flags)
+{
+    return async_handle<T>(res::detail::load_resource_async(typeid(T), name, flags));
+}
+
 template<typename T>
 res::handle<T> res::find(std::string_view name)
 {
@@ -0,0 +1,80 @@
+#include "core/pch.hh"
+
+#include "core/utils/bitset.hh"
+
+#include "core/utils/simd.hh"
+
+void utils::bitset_or(std::span<std::uint64_t> destination, std::span<const std::uint64_t> source) noexcept
+{
+    assert(source.size() >= destination.size());
+
+    auto dst = destination.data();
+    auto src = source.data();
+    auto count = destination.size();
+
+    std::size_t i = 0;
+
+#if defined(CORE_SIMD_SSE2)
+    for(; i + 2 <= count; i += 2) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(a, b));
+    }
+#elif defined(CORE_SIMD_NEON)
+    for(; i + 2 <= count; i += 2) {
+        vst1q_u64(dst + i, vorrq_u64(vld1q_u64(dst + i), vld1q_u64(src + i)));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        dst[i] |= src[i];
+    }
+}
+
+void utils::bitset_and(std::span<std::uint64_t> destination, std::span<const std::uint64_t> source) noexcept
+{
+    assert(source.size() >= destination.size());
+
+    auto dst = destination.data();
+    auto src = source.data();
+    auto count = destination.size();
+
+    std::size_t i = 0;
+
+#if defined(CORE_SIMD_SSE2)
+    for(; i + 2 <= count; i += 2) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_and_si128(a, b));
+    }
+#elif defined(CORE_SIMD_NEON)
+    for(; i + 2 <= count; i += 2) {
+        vst1q_u64(dst + i, vandq_u64(vld1q_u64(dst + i), vld1q_u64(src + i)));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        dst[i] &= src[i];
+    }
+}
+
+std::size_t utils::bitset_popcount(std::span<const std::uint64_t> words) noexcept
+{
+    // Four independent counters keep the popcount
+    // instructions from waiting on a single accumulator
+    std::size_t counts[4] = { 0, 0, 0, 0 };
+    std::size_t i = 0;
+
+    for(; i + 4 <= words.size(); i += 4) {
+        counts[0] += static_cast<std::size_t>(std::popcount(words[i + 0]));
+        counts[1] += static_cast<std::size_t>(std::popcount(words[i + 1]));
+        counts[2] += static_cast<std::size_t>(std::popcount(words[i + 2]));
+        counts[3] += static_cast<std::size_t>(std::popcount(words[i + 3]));
+    }
+
+    for(; i < words.size(); ++i) {
+        counts[0] += static_cast<std::size_t>(std::popcount(words[i]));
+    }
+
+    return counts[0] + counts[1] + counts[2] + counts[3];
+}
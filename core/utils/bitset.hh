@@ -0,0 +1,140 @@
+#ifndef CORE_UTILS_BITSET_HH
+#define CORE_UTILS_BITSET_HH
+#pragma once
+
+namespace utils
+{
+/// Amount of 64-bit words a bitset of a given size takes
+/// @param bits Amount of bits
+/// @return Amount of words
+constexpr std::size_t bitset_words(std::size_t bits) noexcept;
+
+/// Union of two bitsets stored into the first one
+/// @param destination Bitset to merge into
+/// @param source Bitset to merge, must be at least as long as destination
+void bitset_or(std::span<std::uint64_t> destination, std::span<const std::uint64_t> source) noexcept;
+
+/// Intersection of two bitsets stored into the first one
+/// @param destination Bitset to intersect
+/// @param source Bitset to intersect with, must be at least as long as destination
+void bitset_and(std::span<std::uint64_t> destination, std::span<const std::uint64_t> source) noexcept;
+
+/// Count bits that are set
+/// @param words Bitset to count bits in
+/// @return Amount of set bits
+std::size_t bitset_popcount(std::span<const std::uint64_t> words) noexcept;
+
+/// Forward iterator over indices of set bits in ascending order
+class BitsetIterator final {
+public:
+    using value_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    BitsetIterator(void) = default;
+    explicit BitsetIterator(std::span<const std::uint64_t> words, std::size_t word) noexcept;
+
+    std::size_t operator*(void) const noexcept;
+    BitsetIterator& operator++(void) noexcept;
+    BitsetIterator operator++(int) noexcept;
+    bool operator==(const BitsetIterator& other) const noexcept;
+
+private:
+    void skip_empty_words(void) noexcept;
+
+private:
+    std::span<const std::uint64_t> m_words;
+    std::size_t m_word { 0 };
+    std::uint64_t m_bits { 0 };
+};
+
+/// Range over indices of set bits; the bitset is borrowed
+class BitsetRange final {
+public:
+    explicit BitsetRange(std::span<const std::uint64_t> words) noexcept;
+
+    BitsetIterator begin(void) const noexcept;
+    BitsetIterator end(void) const noexcept;
+
+private:
+    std::span<const std::uint64_t> m_words;
+};
+
+/// Iterate over set bits of a bitset, for example
+/// `for(auto leaf : utils::set_bits(row)) { ... }`
+/// @param words Bitset to iterate over
+/// @return Range of set bit indices
+BitsetRange set_bits(std::span<const std::uint64_t> words) noexcept;
+} // namespace utils
+
+constexpr std::size_t utils::bitset_words(std::size_t bits) noexcept
+{
+    return (bits + 63) / 64;
+}
+
+inline utils::BitsetIterator::BitsetIterator(std::span<const std::uint64_t> words, std::size_t word) noexcept : m_words(words), m_word(word)
+{
+    if(m_word < m_words.size()) {
+        m_bits = m_words[m_word];
+        skip_empty_words();
+    }
+    else {
+        m_word = m_words.size();
+    }
+}
+
+inline std::size_t utils::BitsetIterator::operator*(void) const noexcept
+{
+    return m_word * 64 + static_cast<std::size_t>(std::countr_zero(m_bits));
+}
+
+inline utils::BitsetIterator& utils::BitsetIterator::operator++(void) noexcept
+{
+    m_bits &= m_bits - 1;
+    skip_empty_words();
+    return *this;
+}
+
+inline utils::BitsetIterator utils::BitsetIterator::operator++(int) noexcept
+{
+    auto result = *this;
+    ++(*this);
+    return result;
+}
+
+inline bool utils::BitsetIterator::operator==(const BitsetIterator& other) const noexcept
+{
+    return m_word == other.m_word && m_bits == other.m_bits;
+}
+
+inline void utils::BitsetIterator::skip_empty_words(void) noexcept
+{
+    while(!m_bits && ++m_word < m_words.size()) {
+        m_bits = m_words[m_word];
+    }
+
+    if(!m_bits) {
+        m_word = m_words.size();
+    }
+}
+
+inline utils::BitsetRange::BitsetRange(std::span<const std::uint64_t> words) noexcept : m_words(words)
+{
+    // empty
+}
+
+inline utils::BitsetIterator utils::BitsetRange::begin(void) const noexcept
+{
+    return BitsetIterator(m_words, 0);
+}
+
+inline utils::BitsetIterator utils::BitsetRange::end(void) const noexcept
+{
+    return BitsetIterator(m_words, m_words.size());
+}
+
+inline utils::BitsetRange utils::set_bits(std::span<const std::uint64_t> words) noexcept
+{
+    return BitsetRange(words);
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include "core/pch.hh"
+
+#include "core/utils/endian.hh"
+
+#include "core/utils/simd.hh"
+
+constexpr static bool HOST_IS_BIG_ENDIAN = (std::endian::native == std::endian::big);
+
+static std::uint16_t swap_16(std::uint16_t value) noexcept
+{
+    return static_cast<std::uint16_t>((value << 8) | (value >> 8));
+}
+
+static std::uint32_t swap_32(std::uint32_t value) noexcept
+{
+    value = ((value & UINT32_C(0x00FF00FF)) << 8) | ((value & UINT32_C(0xFF00FF00)) >> 8);
+    return (value << 16) | (value >> 16);
+}
+
+static std::uint64_t swap_64(std::uint64_t value) noexcept
+{
+    value = ((value & UINT64_C(0x00FF00FF00FF00FF)) << 8) | ((value & UINT64_C(0xFF00FF00FF00FF00)) >> 8);
+    value = ((value & UINT64_C(0x0000FFFF0000FFFF)) << 16) | ((value & UINT64_C(0xFFFF0000FFFF0000)) >> 16);
+    return (value << 32) | (value >> 32);
+}
+
+#if defined(CORE_SIMD_SSE2)
+static __m128i swap_bytes_16x8(__m128i value) noexcept
+{
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+#endif
+
+void utils::copy_big_endian_16(void* destination, const void* source, std::size_t count) noexcept
+{
+    auto dst = reinterpret_cast<std::byte*>(destination);
+    auto src = reinterpret_cast<const std::byte*>(source);
+
+    if constexpr(HOST_IS_BIG_ENDIAN) {
+        std::memcpy(dst, src, count * sizeof(std::uint16_t));
+        return;
+    }
+
+    std::size_t i = 0;
+
+#if defined(CORE_SIMD_SSE2)
+    for(; i + 8 <= count; i += 8) {
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * sizeof(std::uint16_t)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * sizeof(std::uint16_t)), swap_bytes_16x8(value));
+    }
+#elif defined(CORE_SIMD_NEON)
+    for(; i + 8 <= count; i += 8) {
+        auto value = vld1q_u8(reinterpret_cast<const std::uint8_t*>(src + i * sizeof(std::uint16_t)));
+        vst1q_u8(reinterpret_cast<std::uint8_t*>(dst + i * sizeof(std::uint16_t)), vrev16q_u8(value));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        std::uint16_t value;
+        std::memcpy(&value, src + i * sizeof(value), sizeof(value));
+        value = swap_16(value);
+        std::memcpy(dst + i * sizeof(value), &value, sizeof(value));
+    }
+}
+
+void utils::copy_big_endian_32(void* destination, const void* source, std::size_t count) noexcept
+{
+    auto dst = reinterpret_cast<std::byte*>(destination);
+    auto src = reinterpret_cast<const std::byte*>(source);
+
+    if constexpr(HOST_IS_BIG_ENDIAN) {
+        std::memcpy(dst, src, count * sizeof(std::uint32_t));
+        return;
+    }
+
+    std::size_t i = 0;
+
+#if defined(CORE_SIMD_SSE2)
+    for(; i + 4 <= count; i += 4) {
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * sizeof(std::uint32_t)));
+        value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+        value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * sizeof(std::uint32_t)), swap_bytes_16x8(value));
+    }
+#elif defined(CORE_SIMD_NEON)
+    for(; i + 4 <= count; i += 4) {
+        auto value = vld1q_u8(reinterpret_cast<const std::uint8_t*>(src + i * sizeof(std::uint32_t)));
+        vst1q_u8(reinterpret_cast<std::uint8_t*>(dst + i * sizeof(std::uint32_t)), vrev32q_u8(value));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        std::uint32_t value;
+        std::memcpy(&value, src + i * sizeof(value), sizeof(value));
+        value = swap_32(value);
+        std::memcpy(dst + i * sizeof(value), &value, sizeof(value));
+    }
+}
+
+void utils::copy_big_endian_64(void* destination, const void* source, std::size_t count) noexcept
+{
+    auto dst = reinterpret_cast<std::byte*>(destination);
+    auto src = reinterpret_cast<const std::byte*>(source);
+
+    if constexpr(HOST_IS_BIG_ENDIAN) {
+        std::memcpy(dst, src, count * sizeof(std::uint64_t));
+        return;
+    }
+
+    std::size_t i = 0;
+
+#if defined(CORE_SIMD_SSE2)
+    for(; i + 2 <= count; i += 2) {
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * sizeof(std::uint64_t)));
+        value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+        value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * sizeof(std::uint64_t)), swap_bytes_16x8(value));
+    }
+#elif defined(CORE_SIMD_NEON)
+    for(; i + 2 <= count; i += 2) {
+        auto value = vld1q_u8(reinterpret_cast<const std::uint8_t*>(src + i * sizeof(std::uint64_t)));
+        vst1q_u8(reinterpret_cast<std::uint8_t*>(dst + i * sizeof(std::uint64_t)), vrev64q_u8(value));
+    }
+#endif
+
+    for(; i < count; ++i) {
+        std::uint64_t value;
+        std::memcpy(&value, src + i * sizeof(value), sizeof(value));
+        value = swap_64(value);
+        std::memcpy(dst + i * sizeof(value), &value, sizeof(value));
+    }
+}
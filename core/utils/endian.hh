@@ -0,0 +1,29 @@
+#ifndef CORE_UTILS_ENDIAN_HH
+#define CORE_UTILS_ENDIAN_HH
+#pragma once
+
+namespace utils
+{
+/// Copy an array of 16-bit values converting between host and big-endian
+/// byte order; the conversion is symmetric so this works both ways
+/// @param destination Destination array, must not overlap source
+/// @param source Source array
+/// @param count Amount of values to copy
+void copy_big_endian_16(void* destination, const void* source, std::size_t count) noexcept;
+
+/// Copy an array of 32-bit values converting between host and big-endian
+/// byte order; the conversion is symmetric so this works both ways
+/// @param destination Destination array, must not overlap source
+/// @param source Source array
+/// @param count Amount of values to copy
+void copy_big_endian_32(void* destination, const void* source, std::size_t count) noexcept;
+
+/// Copy an array of 64-bit values converting between host and big-endian
+/// byte order; the conversion is symmetric so this works both ways
+/// @param destination Destination array, must not overlap source
+/// @param source Source array
+/// @param count Amount of values to copy
+void copy_big_endian_64(void* destination, const void* source, std::size_t count) noexcept;
+} // namespace utils
+
+#endif
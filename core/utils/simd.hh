@@ -0,0 +1,16 @@
+#ifndef CORE_UTILS_SIMD_HH
+#define CORE_UTILS_SIMD_HH
+#pragma once
+
+// Vector instruction sets that are always there on the
+// targets we build for; code that uses them keeps a scalar
+// fallback for whatever isn't covered by either of these
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CORE_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CORE_SIMD_NEON 1
+#endif
+
+#endif
@@ -8,7 +8,7 @@
 
 #include "render/texture2d.hh"
 
-static res::handle<Texture2D> s_texture;
+static res::async_handle<Texture2D> s_texture;
 
 static void on_sdl_key(const SDL_KeyboardEvent& event)
 {
@@ -24,7 +24,7 @@ void client_game::init(void)
 
 void client_game::init_late(void)
 {
-    s_texture = res::load<Texture2D>("textures/trollface.png");
+    s_texture = res::load_async<Texture2D>("textures/trollface.png");
 }
 
 void client_game::shutdown(void)
@@ -54,5 +54,7 @@ void client_game::fixed_update_late(void)
 
 void client_game::layout(void)
 {
-    ImGui::Image(s_texture->imgui, ImVec2(256.0f, 196.0f));
+    if(auto texture = s_texture.get()) {
+        ImGui::Image(texture->imgui, ImVec2(256.0f, 196.0f));
+    }
 }
@@ -20,6 +20,10 @@
 #include "render/frontend.hh"
 #include "render/texture2d.hh"
 
+/// Time each frame may spend finalizing resources that have
+/// finished loading in the background, mostly GPU uploads
+constexpr static std::uint64_t RESOURCE_PUMP_BUDGET_US = 2000;
+
 static std::atomic_bool s_is_running;
 
 static void signal_handler(int)
@@ -156,6 +160,8 @@ void client::main(void)
 
         handle_events();
 
+        res::pump(RESOURCE_PUMP_BUDGET_US);
+
         render_frontend::update();
         client_game::update();
 
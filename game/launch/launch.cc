@@ -2,6 +2,7 @@
 
 #include "core/cmdline.hh"
 #include "core/exceptions.hh"
+#include "core/jobs.hh"
 #include "core/paths.hh"
 #include "core/utils/physfs.hh"
 
@@ -27,6 +28,9 @@ static void wrapped_main(int argc, char** argv)
 
     paths::init();
 
+    jobs::init();
+    jobs::DeinitGuard jobs_guard;
+
     auto enet_init_fail = static_cast<bool>(enet_initialize());
     qf::throw_if<std::runtime_error>(enet_init_fail, "failed to initialize enet");
 
@@ -38,6 +42,8 @@ static void wrapped_main(int argc, char** argv)
 
     enet_deinitialize();
 
+    jobs::deinit();
+
     auto physfs_deinit_ok = PHYSFS_deinit();
     qf::throw_if_not_fmt<std::runtime_error>(physfs_deinit_ok, "failed to de-initialize physfs: {}", utils::physfs_error());
 }
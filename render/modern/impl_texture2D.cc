@@ -19,12 +19,31 @@ std::uint32_t build_image_flags(std::uint32_t image_flags, std::uint32_t texture
 static const void* texture2D_load_fn_modern(const char* name, std::uint32_t flags)
 {
     assert(name);
-    assert(globals::gpu_device);
 
     std::uint32_t image_flags = 0;
     image_flags = build_image_flags<RESFLAG_TEX2D_FLIP, RESFLAG_IMG_FLIP>(image_flags, flags);
     image_flags = build_image_flags<RESFLAG_TEX2D_GRAY, RESFLAG_IMG_GRAY>(image_flags, flags);
 
+    // This may run on a worker thread, so the image is
+    // decoded directly instead of going through res::load
+    auto image = Image::decode(name, image_flags);
+
+    if(image == nullptr) {
+        LOG_WARNING("{}: image load failed", name);
+        return nullptr;
+    }
+
+    return image;
+}
+
+static const void* texture2D_finalize_fn_modern(const char* name, std::uint32_t flags, const void* prepared)
+{
+    assert(name);
+    assert(prepared);
+    assert(globals::gpu_device);
+
+    std::unique_ptr<const Image, decltype(&Image::release)> image(reinterpret_cast<const Image*>(prepared), &Image::release);
+
     SDL_GPUTextureFormat image_format;
     std::size_t pixel_size_bytes;
 
@@ -37,13 +56,6 @@ static const void* texture2D_load_fn_modern(const char* name, std::uint32_t flag
         pixel_size_bytes = 4;
     }
 
-    auto image = res::load<Image>(name, image_flags);
-
-    if(image == nullptr) {
-        LOG_WARNING("{}: image load failed", name);
-        return nullptr;
-    }
-
     SDL_GPUTextureCreateInfo texture_info {};
     texture_info.type = SDL_GPU_TEXTURETYPE_2D;
     texture_info.format = image_format;
@@ -109,11 +121,10 @@ static const void* texture2D_load_fn_modern(const char* name, std::uint32_t flag
 
     SDL_EndGPUCopyPass(copy_pass);
 
-    // Submit and wait; this is the blocking part
-    // that shouldn't be used on a per-frame basis
+    // Submit without waiting; the upload is done before any
+    // command buffer submitted later samples the texture and the
+    // transfer buffer is only let go of once the upload is done
     SDL_SubmitGPUCommandBuffer(command_buffer);
-    SDL_WaitForGPUIdle(globals::gpu_device);
-
     SDL_ReleaseGPUTransferBuffer(globals::gpu_device, transfer_buffer);
 
     auto texture = new Texture2D;
@@ -137,5 +148,5 @@ static void texture2D_free_fn_modern(const void* resource)
 
 void Texture2D::register_resource(void)
 {
-    res::register_loader<Texture2D>(&texture2D_load_fn_modern, &texture2D_free_fn_modern);
+    res::register_loader<Texture2D>(&texture2D_load_fn_modern, &texture2D_finalize_fn_modern, &texture2D_free_fn_modern);
 }
@@ -0,0 +1,249 @@
+#include "core/pch.hh"
+
+#include "core/level/level.hh"
+#include "core/level/vertex.hh"
+#include "core/utils/physfs.hh"
+
+// Accuracy test of the packed vertex layout; vertices
+// are saved with and without SAVEFLAG_PACKED_VERTICES and
+// loaded back, the float layout must come back bit for bit
+// and the packed one within the error bounds of its encodings
+
+constexpr static std::size_t CHUNK_COUNT = 64;
+constexpr static std::size_t VERTEX_COUNT = CHUNK_COUNT * PACKED_VERTEX_CHUNK;
+
+/// Octahedral snorm16 keeps unit vectors within
+/// a few thousandths of a degree of where they were
+constexpr static float MAX_NORMAL_ANGLE = 1.0e-4f;
+
+/// Half floats have 11 significant bits, so rounding is off
+/// by at most 2^-11 of the value; large tiling UVs lose
+/// sub-texel precision because of this and not because of a bug
+constexpr static float HALF_RELATIVE_ERROR = 1.0f / 2048.0f;
+constexpr static float HALF_SUBNORMAL_ERROR = 1.0f / 33554432.0f;
+
+constexpr static float UNORM16_STEP = 1.0f / 65535.0f;
+
+static Eigen::Vector3f random_unit_vector(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    if(rng() % 8 == 0) {
+        // Axis-aligned vectors sit right on the
+        // corners and edges of the octahedron
+        Eigen::Vector3f axial(Eigen::Vector3f::Zero());
+        axial[rng() % 3] = (rng() % 2) ? 1.0f : -1.0f;
+        return axial;
+    }
+
+    while(true) {
+        Eigen::Vector3f vector(unit(rng), unit(rng), unit(rng));
+        auto length = vector.norm();
+
+        if(length > 0.01f && length <= 1.0f) {
+            return vector / length;
+        }
+    }
+}
+
+static std::vector<LevelVertex> make_vertices(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unorm(0.0f, 1.0f);
+
+    std::vector<LevelVertex> vertices(VERTEX_COUNT);
+
+    for(std::size_t chunk = 0; chunk < CHUNK_COUNT; ++chunk) {
+        // Chunks range from a few units across to the size
+        // of a whole map; the last one has every vertex in
+        // the same spot and thus bounds with no extent at all
+        auto scale = std::ldexp(1.0f, static_cast<int>(chunk % 14));
+        Eigen::Vector3f origin = 4096.0f * Eigen::Vector3f(unit(rng), unit(rng), unit(rng));
+
+        for(std::size_t i = 0; i < PACKED_VERTEX_CHUNK; ++i) {
+            auto& vertex = vertices[chunk * PACKED_VERTEX_CHUNK + i];
+
+            if(chunk == CHUNK_COUNT - 1) {
+                vertex.position = origin;
+            }
+            else {
+                vertex.position = origin + scale * Eigen::Vector3f(unit(rng), unit(rng), unit(rng));
+            }
+
+            vertex.normal = random_unit_vector(rng);
+            vertex.tangent << random_unit_vector(rng), (rng() % 2) ? 1.0f : -1.0f;
+
+            if(chunk % 2) {
+                // Large tiling texture coordinates
+                vertex.texcoord = 2048.0f * Eigen::Vector2f(unit(rng), unit(rng));
+            }
+            else {
+                vertex.texcoord = 4.0f * Eigen::Vector2f(unit(rng), unit(rng));
+            }
+
+            vertex.lightmap = Eigen::Vector2f(unorm(rng), unorm(rng));
+        }
+    }
+
+    return vertices;
+}
+
+static float vector_angle(const Eigen::Vector3f& a, const Eigen::Vector3f& b)
+{
+    return std::atan2(a.cross(b).norm(), a.dot(b));
+}
+
+static bool is_bit_exact(const LevelVertex& a, const LevelVertex& b)
+{
+    return a.position == b.position && a.normal == b.normal && a.tangent == b.tangent && a.texcoord == b.texcoord
+        && a.lightmap == b.lightmap;
+}
+
+static void roundtrip(const Level& level, Level& result, const std::string& path, std::uint32_t flags)
+{
+    level.save(path, flags);
+    result.load(path);
+
+    PHYSFS_delete(path.c_str());
+}
+
+int main([[maybe_unused]] int argc, char** argv)
+{
+    auto directory = std::filesystem::temp_directory_path().string();
+
+    auto physfs_ok = PHYSFS_init(argv[0]) && PHYSFS_setWriteDir(directory.c_str()) && PHYSFS_mount(directory.c_str(), nullptr, 1);
+
+    if(!physfs_ok) {
+        std::cerr << "failed to set up physfs: " << utils::physfs_error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 rng(9);
+
+    auto vertices = make_vertices(rng);
+
+    std::vector<std::uint32_t> indices(vertices.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    Level level;
+    level.set_geometry(indices, vertices);
+
+    auto unique_name = std::format("qfortress_test_level_vertex_{}", std::chrono::steady_clock::now().time_since_epoch().count());
+
+    Level float_level;
+    Level packed_level;
+    roundtrip(level, float_level, unique_name + "_float.qflv", 0);
+    roundtrip(level, packed_level, unique_name + "_packed.qflv", SAVEFLAG_PACKED_VERTICES);
+
+    PHYSFS_deinit();
+
+    if(float_level.vertices().size() != vertices.size() || packed_level.vertices().size() != vertices.size()) {
+        std::cerr << "vertex count mismatch" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if(float_level.indices() != indices || packed_level.indices() != indices) {
+        std::cerr << "index mismatch" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::size_t failures = 0;
+
+    auto fail = [&failures](std::size_t index, std::string_view what, float error, float tolerance) {
+        if(failures < 16) {
+            std::cerr << "vertex " << index << ": " << what << " error " << error << " exceeds " << tolerance << std::endl;
+        }
+
+        failures += 1;
+    };
+
+    float max_position_steps = 0.0f;
+    float max_normal_angle = 0.0f;
+    float max_tangent_angle = 0.0f;
+    float max_texcoord_error = 0.0f;
+    float max_lightmap_error = 0.0f;
+
+    for(std::size_t chunk = 0; chunk < CHUNK_COUNT; ++chunk) {
+        Eigen::AlignedBox3f bounds;
+
+        for(std::size_t i = 0; i < PACKED_VERTEX_CHUNK; ++i) {
+            bounds.extend(vertices[chunk * PACKED_VERTEX_CHUNK + i].position);
+        }
+
+        Eigen::Vector3f extent(bounds.sizes());
+        Eigen::Vector3f magnitude(bounds.min().cwiseAbs().cwiseMax(bounds.max().cwiseAbs()));
+
+        for(std::size_t i = 0; i < PACKED_VERTEX_CHUNK; ++i) {
+            auto index = chunk * PACKED_VERTEX_CHUNK + i;
+            const auto& expected = vertices[index];
+            const auto& packed = packed_level.vertices()[index];
+
+            if(!is_bit_exact(float_level.vertices()[index], expected)) {
+                fail(index, "float layout", 1.0f, 0.0f);
+            }
+
+            for(int axis = 0; axis < 3; ++axis) {
+                // Half a quantization step within the chunk
+                // bounds plus rounding of the float arithmetic;
+                // bounds with no extent have to come back exact
+                auto error = std::abs(packed.position[axis] - expected.position[axis]);
+                auto tolerance = 0.0f;
+
+                if(extent[axis] > 0.0f) {
+                    tolerance = 0.5f * UNORM16_STEP * extent[axis] + 4.0f * std::numeric_limits<float>::epsilon() * magnitude[axis];
+                }
+
+                if(error > tolerance) {
+                    fail(index, "position", error, tolerance);
+                }
+
+                if(extent[axis] > 0.0f) {
+                    max_position_steps = std::max(max_position_steps, error / (UNORM16_STEP * extent[axis]));
+                }
+            }
+
+            auto normal_angle = vector_angle(packed.normal, expected.normal);
+            auto tangent_angle = vector_angle(packed.tangent.head<3>(), expected.tangent.head<3>());
+
+            if(!(normal_angle <= MAX_NORMAL_ANGLE)) {
+                fail(index, "normal angle", normal_angle, MAX_NORMAL_ANGLE);
+            }
+
+            if(!(tangent_angle <= MAX_NORMAL_ANGLE)) {
+                fail(index, "tangent angle", tangent_angle, MAX_NORMAL_ANGLE);
+            }
+
+            if(packed.tangent.w() != expected.tangent.w()) {
+                fail(index, "tangent sign", std::abs(packed.tangent.w() - expected.tangent.w()), 0.0f);
+            }
+
+            max_normal_angle = std::max(max_normal_angle, normal_angle);
+            max_tangent_angle = std::max(max_tangent_angle, tangent_angle);
+
+            for(int axis = 0; axis < 2; ++axis) {
+                auto texcoord_error = std::abs(packed.texcoord[axis] - expected.texcoord[axis]);
+                auto texcoord_tolerance = HALF_RELATIVE_ERROR * std::abs(expected.texcoord[axis]) + HALF_SUBNORMAL_ERROR;
+
+                if(!(texcoord_error <= texcoord_tolerance)) {
+                    fail(index, "texcoord", texcoord_error, texcoord_tolerance);
+                }
+
+                auto lightmap_error = std::abs(packed.lightmap[axis] - expected.lightmap[axis]);
+                auto lightmap_tolerance = 0.5f * UNORM16_STEP + std::numeric_limits<float>::epsilon();
+
+                if(!(lightmap_error <= lightmap_tolerance)) {
+                    fail(index, "lightmap", lightmap_error, lightmap_tolerance);
+                }
+
+                max_texcoord_error = std::max(max_texcoord_error, texcoord_error);
+                max_lightmap_error = std::max(max_lightmap_error, lightmap_error);
+            }
+        }
+    }
+
+    std::cout << VERTEX_COUNT << " vertices checked, " << failures << " failures" << std::endl;
+    std::cout << "max errors: position " << max_position_steps << " steps, normal " << max_normal_angle << " rad, tangent "
+              << max_tangent_angle << " rad, texcoord " << max_texcoord_error << ", lightmap " << max_lightmap_error << std::endl;
+
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,191 @@
+#include "core/pch.hh"
+
+#include "core/level/level.hh"
+#include "core/math/plane.hh"
+
+// Randomized equivalence test of every point location path
+// against a plain binary walk; the walk keeps every product
+// and sum in a volatile so that it can't be contracted into
+// FMA, which means a mismatch in any of the other paths points
+// at a compiler fusing the operations they rely on being unfused
+
+constexpr static int TREE_COUNT = 64;
+constexpr static int MAX_TREE_DEPTH = 18;
+constexpr static std::size_t POINTS_PER_TREE = 50000;
+constexpr static float WORLD_EXTENT = 1024.0f;
+
+static std::int32_t binary_find_leaf(const Level& level, const Eigen::Vector3f& position)
+{
+    auto child = level.root_node();
+
+    while(child >= 0) {
+        auto plane = level.plane(static_cast<std::size_t>(child));
+        auto type = level.nodes()[child].plane_type;
+
+        volatile float distance;
+
+        if(type < PLANE_ANY) {
+            volatile float product = plane.coeffs()[type] * position[type];
+            distance = product + plane.coeffs()[3];
+        }
+        else {
+            volatile float product_x = plane.coeffs()[0] * position.x();
+            volatile float product_y = plane.coeffs()[1] * position.y();
+            volatile float product_z = plane.coeffs()[2] * position.z();
+            volatile float sum_xy = product_x + product_y;
+            volatile float sum_xyz = sum_xy + product_z;
+            distance = sum_xyz + plane.coeffs()[3];
+        }
+
+        child = level.nodes()[child].children[(distance >= 0.0f) ? 0 : 1];
+    }
+
+    return (child == LEVEL_CHILD_NONE) ? -1 : ~child;
+}
+
+static std::int32_t build_random_tree(std::mt19937& rng, int depth, const Eigen::AlignedBox3f& box, std::vector<Level::Node>& nodes,
+    std::vector<Eigen::Vector3f>& plane_points)
+{
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    if(depth == 0 || rng() % 13 == 0) {
+        if(rng() % 5 == 0) {
+            return -1; // solid space
+        }
+
+        nodes.emplace_back(Level::Leaf {});
+        return static_cast<std::int32_t>(nodes.size() - 1);
+    }
+
+    Eigen::Vector3f normal(unit(rng), unit(rng), unit(rng));
+
+    switch(rng() % 3) {
+        case 0:
+            // Axial, either facing along or against the axis
+            normal.setZero();
+            normal[rng() % 3] = (rng() % 2) ? 1.0f : -1.0f;
+            break;
+
+        case 1:
+            normal.normalize();
+            break;
+
+        default:
+            // Oblique and not normalized at all
+            break;
+    }
+
+    Eigen::Vector3f point = box.center() + 0.2f * Eigen::Vector3f(unit(rng), unit(rng), unit(rng)).cwiseProduct(box.sizes());
+    plane_points.push_back(point);
+
+    Level::Internal internal;
+    internal.plane = Eigen::Hyperplane<float, 3>(normal, -normal.dot(point));
+
+    auto index = static_cast<std::int32_t>(nodes.size());
+    nodes.emplace_back(internal);
+
+    auto axis = depth % 3;
+    Eigen::AlignedBox3f front_box = box;
+    Eigen::AlignedBox3f back_box = box;
+    front_box.min()[axis] = box.center()[axis];
+    back_box.max()[axis] = box.center()[axis];
+
+    auto front = build_random_tree(rng, depth - 1, front_box, nodes, plane_points);
+    auto back = build_random_tree(rng, depth - 1, back_box, nodes, plane_points);
+
+    std::get<Level::Internal>(nodes[index]).front = front;
+    std::get<Level::Internal>(nodes[index]).back = back;
+
+    return index;
+}
+
+int main(void)
+{
+    std::size_t mismatches = 0;
+    std::size_t checked = 0;
+
+    for(int seed = 0; seed < TREE_COUNT; ++seed) {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(seed));
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        std::vector<Level::Node> nodes;
+        std::vector<Eigen::Vector3f> plane_points;
+
+        Eigen::AlignedBox3f world(Eigen::Vector3f::Constant(-WORLD_EXTENT), Eigen::Vector3f::Constant(WORLD_EXTENT));
+        auto root = build_random_tree(rng, 2 + seed % (MAX_TREE_DEPTH - 1), world, nodes, plane_points);
+
+        if(root < 0) {
+            continue;
+        }
+
+        Level level;
+        level.set_nodes(nodes, root);
+
+        if(level.root_node() < 0) {
+            // The whole tree is a single leaf
+            continue;
+        }
+
+        if(level.wide_tree().empty()) {
+            std::cerr << "seed " << seed << ": wide tree was not built" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::vector<Eigen::Vector3f> points(POINTS_PER_TREE);
+
+        for(std::size_t i = 0; i < points.size(); ++i) {
+            switch(i % 4) {
+                case 0:
+                    // Exactly on one of the planes
+                    points[i] = plane_points[rng() % plane_points.size()];
+                    break;
+
+                case 1:
+                    // Integer coordinates land on axial planes a lot
+                    points[i] = Eigen::Vector3f(std::round(unit(rng) * WORLD_EXTENT), std::round(unit(rng) * WORLD_EXTENT),
+                        std::round(unit(rng) * WORLD_EXTENT));
+                    break;
+
+                default:
+                    // Anywhere, including a bit outside of the world
+                    points[i] = 1.1f * WORLD_EXTENT * Eigen::Vector3f(unit(rng), unit(rng), unit(rng));
+                    break;
+            }
+        }
+
+        std::vector<std::int32_t> batch(points.size());
+        level.find_leaf_indices(points, batch);
+
+        // The hinted lookup starts from wherever the previous
+        // point was, which exercises both the upward walk from
+        // the hint and the descent from the crossed plane
+        auto previous = std::int32_t(-1);
+
+        for(std::size_t i = 0; i < points.size(); ++i) {
+            auto expected = binary_find_leaf(level, points[i]);
+
+            float clearance;
+            auto wide = level.wide_tree().find_leaf_index(points[i]);
+            auto located = level.find_leaf_index(points[i]);
+            auto hinted = level.find_leaf_index(points[i], previous, clearance);
+
+            previous = expected;
+
+            if(wide != expected || located != expected || hinted != expected || batch[i] != expected) {
+                if(mismatches < 16) {
+                    std::cerr << "seed " << seed << ": point (" << points[i].x() << ", " << points[i].y() << ", " << points[i].z()
+                              << ") binary " << expected << " wide " << wide << " find_leaf_index " << located << " hinted " << hinted
+                              << " find_leaf_indices " << batch[i] << std::endl;
+                }
+
+                mismatches += 1;
+            }
+
+            checked += 1;
+        }
+    }
+
+    std::cout << checked << " points checked, " << mismatches << " mismatches" << std::endl;
+
+    return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,40 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/cmdline.hh"
+#include "core/exceptions.hh"
+
+std::size_t bench::option_or(std::string_view option, std::size_t default_value)
+{
+    auto value = cmdline::value_or(option, std::string_view());
+
+    if(value.empty()) {
+        return default_value;
+    }
+
+    std::size_t result = 0;
+    auto check = std::from_chars(value.data(), value.data() + value.size(), result);
+    qf::throw_if_not_fmt<std::invalid_argument>(check.ec == std::errc() && check.ptr == value.data() + value.size(),
+        "option -{}: {} is not a number", option, value);
+
+    return result;
+}
+
+double bench::elapsed_ms(std::chrono::steady_clock::time_point start) noexcept
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double bench::best_of(std::size_t runs, const std::function<void(void)>& fn)
+{
+    auto best = std::numeric_limits<double>::infinity();
+
+    for(std::size_t i = 0; i < std::max<std::size_t>(runs, 1); ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, elapsed_ms(start));
+    }
+
+    return best;
+}
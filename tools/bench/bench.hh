@@ -0,0 +1,39 @@
+#ifndef TOOLS_BENCH_BENCH_HH
+#define TOOLS_BENCH_BENCH_HH
+#pragma once
+
+namespace bench
+{
+/// Numeric command line option
+/// @param option Option name without the leading dash
+/// @param default_value Value to use when the option is absent
+/// @return Option value
+std::size_t option_or(std::string_view option, std::size_t default_value);
+
+/// Milliseconds elapsed since a point in time
+/// @param start Point in time to measure from
+/// @return Elapsed time in milliseconds
+double elapsed_ms(std::chrono::steady_clock::time_point start) noexcept;
+
+/// Best time out of several runs of a function; the
+/// first result is usually off because of cold caches
+/// @param runs Amount of runs, at least one
+/// @param fn Function to time
+/// @return Shortest run time in milliseconds
+double best_of(std::size_t runs, const std::function<void(void)>& fn);
+} // namespace bench
+
+namespace bench
+{
+void bitstream(void);
+void buffer_span(void);
+void job_scaling(void);
+void leaf_batch(void);
+void leaf_lookup(void);
+void level_load(void);
+void portal_flow(void);
+void pvs_bitset(void);
+void trace(void);
+} // namespace bench
+
+#endif
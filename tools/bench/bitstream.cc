@@ -0,0 +1,118 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/bitstream.hh"
+#include "core/buffer.hh"
+#include "core/exceptions.hh"
+
+template<typename WriteFunc, typename ReadFunc, typename ExpectFunc>
+static void run_bitstream_case(std::string_view name, const std::vector<std::uint64_t>& values, std::size_t runs, WriteFunc write,
+    ReadFunc read, ExpectFunc expect)
+{
+    BitWriter writer;
+
+    auto write_ms = bench::best_of(runs, [&] {
+        writer.reset();
+
+        for(auto value : values) {
+            write(writer, value);
+        }
+
+        writer.flush();
+    });
+
+    std::uint64_t mismatches = 0;
+
+    auto read_ms = bench::best_of(runs, [&] {
+        BitReader reader(writer.data(), writer.size());
+
+        mismatches = 0;
+
+        for(auto value : values) {
+            mismatches += (read(reader) != expect(value)) ? 1 : 0;
+        }
+    });
+
+    qf::throw_if_not_fmt<std::runtime_error>(mismatches == 0, "{}: {} values did not round trip", name, mismatches);
+
+    auto count = static_cast<double>(values.size());
+
+    LOG_INFO("{}: {:.2f} bits/value, write {:.0f} M/s, read {:.0f} M/s", name, 8.0 * static_cast<double>(writer.size()) / count,
+        count / (write_ms * 1000.0), count / (read_ms * 1000.0));
+}
+
+void bench::bitstream(void)
+{
+    auto count = bench::option_or("values", 10000000);
+    auto runs = bench::option_or("runs", 5);
+
+    std::mt19937_64 rng(42);
+
+    // Magnitudes are spread evenly on a log scale,
+    // from a single bit up to full 64-bit values
+    std::vector<std::uint64_t> values(count);
+
+    for(auto& value : values) {
+        value = rng() >> (rng() % 64);
+    }
+
+    LOG_INFO("{} values per case", count);
+
+    for(unsigned int bits : { 1U, 5U, 13U, 32U }) {
+        auto mask = (bits == 32) ? UINT64_C(0xFFFFFFFF) : ((UINT64_C(1) << bits) - 1);
+
+        run_bitstream_case(
+            std::format("bits {}", bits), values, runs,
+            [bits](BitWriter& writer, std::uint64_t value) {
+                writer.write_bits(static_cast<std::uint32_t>(value), bits);
+            },
+            [bits](BitReader& reader) {
+                return static_cast<std::uint64_t>(reader.read_bits(bits));
+            },
+            [mask](std::uint64_t value) {
+                return value & mask;
+            });
+    }
+
+    run_bitstream_case(
+        "varint", values, runs,
+        [](BitWriter& writer, std::uint64_t value) {
+            writer.write_varint(value);
+        },
+        [](BitReader& reader) {
+            return reader.read_varint();
+        },
+        [](std::uint64_t value) {
+            return value;
+        });
+
+    run_bitstream_case(
+        "zigzag", values, runs,
+        [](BitWriter& writer, std::uint64_t value) {
+            writer.write_zigzag(static_cast<std::int64_t>(value) >> 1);
+        },
+        [](BitReader& reader) {
+            return static_cast<std::uint64_t>(reader.read_zigzag());
+        },
+        [](std::uint64_t value) {
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(value) >> 1);
+        });
+
+    // Byte-aligned baseline; this is what 13-bit
+    // values cost when written through WriteBuffer
+    WriteBuffer buffer;
+
+    auto buffer_ms = bench::best_of(runs, [&] {
+        buffer.reset();
+
+        for(auto value : values) {
+            buffer.write<std::uint16_t>(static_cast<std::uint16_t>(value & 0x1FFF));
+        }
+    });
+
+    auto buffer_count = static_cast<double>(count);
+
+    LOG_INFO("WriteBuffer uint16: {:.2f} bits/value, write {:.0f} M/s", 8.0 * static_cast<double>(buffer.size()) / buffer_count,
+        buffer_count / (buffer_ms * 1000.0));
+}
@@ -0,0 +1,71 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/buffer.hh"
+#include "core/exceptions.hh"
+
+template<typename T>
+static void run_buffer_span(std::string_view type_name, std::size_t size_mib, std::size_t runs)
+{
+    auto count = (size_mib * 1048576) / sizeof(T);
+    auto size_mib_f = static_cast<double>(count * sizeof(T)) / 1048576.0;
+
+    std::vector<T> values(count);
+    std::vector<T> result(count);
+
+    std::mt19937_64 rng(42);
+
+    for(auto& value : values) {
+        value = static_cast<T>(rng());
+    }
+
+    WriteBuffer writer;
+
+    auto write_element_ms = bench::best_of(runs, [&] {
+        writer.reset();
+
+        for(const auto& value : values) {
+            writer.write<T>(value);
+        }
+    });
+
+    auto write_span_ms = bench::best_of(runs, [&] {
+        writer.reset();
+        writer.write_span<T>(values);
+    });
+
+    ReadBuffer reader;
+    reader.borrow(writer.data(), writer.size());
+
+    auto read_element_ms = bench::best_of(runs, [&] {
+        reader.rewind();
+
+        for(auto& value : result) {
+            value = reader.read<T>();
+        }
+    });
+
+    auto read_span_ms = bench::best_of(runs, [&] {
+        reader.rewind();
+        reader.read_span<T>(result);
+    });
+
+    qf::throw_if_not_fmt<std::runtime_error>(result == values, "{}: values did not survive a round trip", type_name);
+
+    LOG_INFO("{}: write {:.0f} -> {:.0f} MiB/s, read {:.0f} -> {:.0f} MiB/s", type_name, size_mib_f / (write_element_ms / 1000.0),
+        size_mib_f / (write_span_ms / 1000.0), size_mib_f / (read_element_ms / 1000.0), size_mib_f / (read_span_ms / 1000.0));
+}
+
+void bench::buffer_span(void)
+{
+    auto size_mib = bench::option_or("mib", 64);
+    auto runs = bench::option_or("runs", 5);
+
+    LOG_INFO("{} MiB per type, per-element -> span", size_mib);
+
+    run_buffer_span<std::uint16_t>("uint16", size_mib, runs);
+    run_buffer_span<std::uint32_t>("uint32", size_mib, runs);
+    run_buffer_span<std::uint64_t>("uint64", size_mib, runs);
+    run_buffer_span<float>("float", size_mib, runs);
+}
@@ -0,0 +1,104 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/cmdline.hh"
+#include "core/exceptions.hh"
+#include "core/jobs.hh"
+#include "core/level/level.hh"
+
+#include "tools/bench/random_level.hh"
+
+struct ScalingTimes final {
+    double trace_ms;
+    double leaves_ms;
+};
+
+static ScalingTimes run_job_scaling(const Level& level, std::span<const Level::Ray> rays, std::span<const Eigen::Vector3f> points,
+    std::size_t runs)
+{
+    std::vector<Level::TraceResult> results(rays.size());
+    std::vector<std::int32_t> leaves(points.size());
+
+    ScalingTimes times;
+
+    times.trace_ms = bench::best_of(runs, [&] {
+        level.trace_rays(rays, results);
+    });
+
+    times.leaves_ms = bench::best_of(runs, [&] {
+        level.find_leaf_indices(points, leaves);
+    });
+
+    return times;
+}
+
+void bench::job_scaling(void)
+{
+    auto depth = bench::option_or("depth", 16);
+    auto count = bench::option_or("rays", 1000000);
+    auto runs = bench::option_or("runs", 3);
+
+    std::vector<Level::Node> nodes;
+    auto root = bench::make_random_nodes(depth, 1, nodes);
+
+    Level level;
+    level.set_nodes(nodes, root);
+
+    auto points = bench::make_random_points(count, 2);
+    auto ends = bench::make_random_points(count, 3);
+
+    std::vector<Level::Ray> rays(count);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        rays[i].start = points[i];
+        rays[i].end = points[i] + 300.0f * (ends[i] - points[i]).normalized();
+    }
+
+    LOG_INFO("{} internal nodes, {} rays and points per run", level.nodes().size(), count);
+
+    // The "jobs" option pins the worker count like it does
+    // for the game and is compared against a single thread;
+    // without it every thread count up to the amount of
+    // hardware threads is measured
+    constexpr static int WORKERS_FROM_CMDLINE = -1;
+
+    std::vector<int> worker_counts;
+    worker_counts.push_back(0);
+
+    if(cmdline::contains("jobs")) {
+        worker_counts.push_back(WORKERS_FROM_CMDLINE);
+    }
+    else {
+        auto hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+
+        for(int i = 1; i < hardware_threads; ++i) {
+            worker_counts.push_back(i);
+        }
+    }
+
+    ScalingTimes baseline {};
+
+    for(std::size_t i = 0; i < worker_counts.size(); ++i) {
+        if(worker_counts[i] == WORKERS_FROM_CMDLINE) {
+            jobs::init();
+        }
+        else {
+            jobs::init(static_cast<unsigned int>(worker_counts[i]));
+        }
+
+        jobs::DeinitGuard jobs_guard;
+
+        auto times = run_job_scaling(level, rays, points, runs);
+        auto threads = jobs::thread_count();
+
+        jobs::deinit();
+
+        if(i == 0) {
+            baseline = times;
+        }
+
+        LOG_INFO("{} threads: trace_rays {:.1f} ms ({:.2f}x), find_leaf_indices {:.1f} ms ({:.2f}x)", threads, times.trace_ms,
+            baseline.trace_ms / times.trace_ms, times.leaves_ms, baseline.leaves_ms / times.leaves_ms);
+    }
+}
@@ -0,0 +1,97 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/entity/current_leaf.hh"
+#include "core/entity/transform.hh"
+#include "core/exceptions.hh"
+#include "core/level/level.hh"
+
+#include "tools/bench/random_level.hh"
+
+static void run_point_batch(const Level& level, std::span<const Eigen::Vector3f> points, std::size_t runs)
+{
+    std::vector<std::int32_t> single_leaves(points.size());
+    std::vector<std::int32_t> batch_leaves(points.size());
+
+    auto single_ms = bench::best_of(runs, [&] {
+        for(std::size_t i = 0; i < points.size(); ++i) {
+            single_leaves[i] = level.find_leaf_index(points[i]);
+        }
+    });
+
+    auto batch_ms = bench::best_of(runs, [&] {
+        level.find_leaf_indices(points, batch_leaves);
+    });
+
+    qf::throw_if_not_fmt<std::runtime_error>(single_leaves == batch_leaves, "{} points: batched leaves differ", points.size());
+
+    LOG_INFO("{} points: {:.2f} ms -> {:.2f} ms", points.size(), single_ms, batch_ms);
+}
+
+static void run_entity_batch(Level& level, std::span<const Eigen::Vector3f> points, std::size_t runs)
+{
+    auto& registry = level.registry();
+
+    auto create_entities = [&registry, points] {
+        registry.clear();
+
+        for(const auto& point : points) {
+            registry.emplace<Transform>(registry.create(), point, Eigen::Quaternionf::Identity());
+        }
+    };
+
+    double single_ms = std::numeric_limits<double>::infinity();
+    double batch_ms = std::numeric_limits<double>::infinity();
+
+    // Entity creation isn't part of what's timed
+    // so the runs are timed one by one here
+    for(std::size_t i = 0; i < std::max<std::size_t>(runs, 1); ++i) {
+        create_entities();
+
+        single_ms = std::min(single_ms, bench::best_of(1, [&registry, &level] {
+            for(auto [entity, transform] : registry.view<Transform>().each()) {
+                registry.emplace<CurrentLeaf>(entity, level.find_leaf_index(transform.position()));
+            }
+        }));
+
+        create_entities();
+
+        batch_ms = std::min(batch_ms, bench::best_of(1, [&level] {
+            CurrentLeaf::fixed_update(level);
+        }));
+    }
+
+    registry.clear();
+
+    LOG_INFO("{} entities placed: {:.2f} ms -> {:.2f} ms", points.size(), single_ms, batch_ms);
+}
+
+void bench::leaf_batch(void)
+{
+    auto depth = bench::option_or("depth", 16);
+    auto max_points = bench::option_or("points", 1000000);
+    auto runs = bench::option_or("runs", 5);
+
+    std::vector<Level::Node> nodes;
+    auto root = bench::make_random_nodes(depth, 1, nodes);
+
+    Level level;
+    level.set_nodes(nodes, root);
+
+    auto points = bench::make_random_points(max_points, 2);
+
+    LOG_INFO("{} internal nodes, {} leaves, per-point -> batched", level.nodes().size(), level.leaves().size());
+
+    for(std::size_t count = 10000; count < max_points; count *= 10) {
+        run_point_batch(level, std::span(points).first(count), runs);
+    }
+
+    run_point_batch(level, points, runs);
+
+    for(std::size_t count = 10000; count < max_points; count *= 10) {
+        run_entity_batch(level, std::span(points).first(count), runs);
+    }
+
+    run_entity_batch(level, points, runs);
+}
@@ -0,0 +1,118 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/exceptions.hh"
+#include "core/level/level.hh"
+
+#include "tools/bench/random_level.hh"
+
+// The variant walks below are how the tree was walked
+// before it was flattened: recursion over authored nodes
+// with an std::get_if on every step and the full plane distance
+
+static std::int32_t variant_find_leaf(const std::vector<Level::Node>& nodes, std::int32_t node_index, const Eigen::Vector3f& position)
+{
+    if(node_index >= 0 && static_cast<std::size_t>(node_index) < nodes.size()) {
+        const auto& node = nodes[node_index];
+
+        if(std::get_if<Level::Leaf>(&node)) {
+            return node_index;
+        }
+
+        if(const auto internal = std::get_if<Level::Internal>(&node)) {
+            if(internal->plane.signedDistance(position) >= 0.0f) {
+                return variant_find_leaf(nodes, internal->front, position);
+            }
+            else {
+                return variant_find_leaf(nodes, internal->back, position);
+            }
+        }
+    }
+
+    return -1;
+}
+
+static void variant_enumerate(const std::vector<Level::Node>& nodes, std::int32_t node_index, const Eigen::Vector3f& position,
+    std::vector<const Level::Node*>& out_nodes)
+{
+    if(node_index >= 0 && static_cast<std::size_t>(node_index) < nodes.size()) {
+        const auto& node = nodes[node_index];
+
+        if(const auto internal = std::get_if<Level::Internal>(&node)) {
+            if(internal->plane.signedDistance(position) >= 0.0f) {
+                variant_enumerate(nodes, internal->back, position, out_nodes);
+                out_nodes.push_back(&node);
+                variant_enumerate(nodes, internal->front, position, out_nodes);
+            }
+            else {
+                variant_enumerate(nodes, internal->front, position, out_nodes);
+                out_nodes.push_back(&node);
+                variant_enumerate(nodes, internal->back, position, out_nodes);
+            }
+        }
+        else {
+            out_nodes.push_back(&node);
+        }
+    }
+}
+
+void bench::leaf_lookup(void)
+{
+    auto depth = bench::option_or("depth", 20);
+    auto point_count = bench::option_or("points", 1000000);
+    auto enumerations = bench::option_or("enumerations", 50);
+    auto runs = bench::option_or("runs", 3);
+
+    std::vector<Level::Node> nodes;
+    auto root = bench::make_random_nodes(depth, 1, nodes);
+
+    Level level;
+    level.set_nodes(nodes, root);
+
+    auto points = bench::make_random_points(point_count, 2);
+
+    LOG_INFO("{} authored nodes, {} internal nodes, {} leaves", nodes.size(), level.nodes().size(), level.leaves().size());
+
+    std::size_t variant_solid = 0;
+    std::size_t flat_solid = 0;
+
+    auto variant_ms = bench::best_of(runs, [&] {
+        variant_solid = 0;
+
+        for(const auto& point : points) {
+            variant_solid += (variant_find_leaf(nodes, root, point) < 0) ? 1 : 0;
+        }
+    });
+
+    auto flat_ms = bench::best_of(runs, [&] {
+        flat_solid = 0;
+
+        for(const auto& point : points) {
+            flat_solid += (level.find_leaf_index(point) < 0) ? 1 : 0;
+        }
+    });
+
+    qf::throw_if_not_fmt<std::runtime_error>(variant_solid == flat_solid, "solid point count mismatch: {} variant, {} flat", variant_solid,
+        flat_solid);
+
+    LOG_INFO("{} point lookups: {:.1f} ms -> {:.1f} ms", point_count, variant_ms, flat_ms);
+
+    std::vector<const Level::Node*> variant_out;
+    std::vector<std::int32_t> flat_out;
+
+    auto variant_enumerate_ms = bench::best_of(runs, [&] {
+        for(std::size_t i = 0; i < enumerations; ++i) {
+            variant_enumerate(nodes, root, points[i % points.size()], variant_out);
+            variant_out.clear();
+        }
+    });
+
+    auto flat_enumerate_ms = bench::best_of(runs, [&] {
+        for(std::size_t i = 0; i < enumerations; ++i) {
+            level.enumerate(points[i % points.size()], flat_out);
+        }
+    });
+
+    LOG_INFO("{} full enumerations: {:.1f} ms -> {:.1f} ms", enumerations, variant_enumerate_ms, flat_enumerate_ms);
+}
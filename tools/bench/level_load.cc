@@ -0,0 +1,216 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/buffer.hh"
+#include "core/cmdline.hh"
+#include "core/exceptions.hh"
+#include "core/level/level.hh"
+#include "core/utils/physfs.hh"
+
+constexpr static std::string_view BENCH_LEVEL_PATH = "bench_level_load.qflv";
+
+constexpr static std::size_t TRAILER_SIZE = 4;
+constexpr static std::size_t VTX_FLOATS_PER_VERTEX = 14;
+
+#if defined(__linux__)
+
+static std::size_t read_status_kib(std::string_view key)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+
+    while(std::getline(status, line)) {
+        if(line.starts_with(key) && line.size() > key.size() && line[key.size()] == ':') {
+            return static_cast<std::size_t>(std::strtoull(line.c_str() + key.size() + 1, nullptr, 10));
+        }
+    }
+
+    return 0;
+}
+
+static bool reset_peak_rss(void)
+{
+    // Writing 5 to clear_refs resets VmHWM to
+    // the current resident set size (Linux 4.0+)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5" << std::endl;
+    return clear_refs.good();
+}
+
+#else
+
+static std::size_t read_status_kib(std::string_view)
+{
+    return 0;
+}
+
+static bool reset_peak_rss(void)
+{
+    return false;
+}
+
+#endif
+
+/// Peak resident set growth while running a function;
+/// zero when the platform can't reset the peak
+static std::size_t peak_rss_growth_kib(const std::function<void(void)>& fn)
+{
+    if(!reset_peak_rss()) {
+        fn();
+        return 0;
+    }
+
+    auto resident = read_status_kib("VmRSS");
+    fn();
+    auto peak = read_status_kib("VmHWM");
+
+    return (peak > resident) ? peak - resident : 0;
+}
+
+static void save_random_level(std::size_t vertex_count, std::uint32_t flags)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unorm(0.0f, 1.0f);
+
+    std::vector<LevelVertex> vertices(vertex_count);
+
+    for(auto& vertex : vertices) {
+        vertex.position = 4096.0f * Eigen::Vector3f(unit(rng), unit(rng), unit(rng));
+        vertex.normal = Eigen::Vector3f(unit(rng), unit(rng), unit(rng)).normalized();
+        vertex.tangent << Eigen::Vector3f(unit(rng), unit(rng), unit(rng)).normalized(), 1.0f;
+        vertex.texcoord = 16.0f * Eigen::Vector2f(unit(rng), unit(rng));
+        vertex.lightmap = Eigen::Vector2f(unorm(rng), unorm(rng));
+    }
+
+    std::vector<std::uint32_t> indices(3 * vertex_count);
+
+    for(auto& index : indices) {
+        index = static_cast<std::uint32_t>(rng() % vertex_count);
+    }
+
+    Level level;
+    level.set_geometry(indices, vertices);
+    level.save(BENCH_LEVEL_PATH, flags);
+}
+
+static double level_file_mib(void)
+{
+    PHYSFS_Stat stat;
+    auto stat_ok = PHYSFS_stat(BENCH_LEVEL_PATH.data(), &stat);
+    qf::throw_if_not_fmt<std::runtime_error>(stat_ok, "{}: {}", BENCH_LEVEL_PATH, utils::physfs_error());
+
+    return static_cast<double>(stat.filesize) / 1048576.0;
+}
+
+/// The loader Level::load replaced: the whole file is copied into
+/// an owned buffer and the vertex lump, which is the only lump of the
+/// bench level and ends right before the trailer, is decoded one
+/// bounds-checked read<float> at a time
+static void load_copied(std::size_t vertex_count, std::vector<std::uint32_t>& out_indices, std::vector<LevelVertex>& out_vertices)
+{
+    auto file = PHYSFS_openRead(BENCH_LEVEL_PATH.data());
+    qf::throw_if_not_fmt<std::runtime_error>(file, "{}: {}", BENCH_LEVEL_PATH, utils::physfs_error());
+
+    ReadBuffer buffer;
+    buffer.reset(file);
+    PHYSFS_close(file);
+
+    auto lump_size = (2 + 3 * vertex_count) * sizeof(std::uint32_t) + vertex_count * VTX_FLOATS_PER_VERTEX * sizeof(float);
+    qf::throw_if<std::runtime_error>(lump_size + TRAILER_SIZE > buffer.size(), "unexpected end-of-file");
+
+    buffer.read_view(buffer.size() - TRAILER_SIZE - lump_size);
+
+    out_indices.resize(buffer.read<std::uint32_t>());
+
+    for(std::size_t i = 0; i < out_indices.size(); ++i) {
+        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+
+        out_indices[i] = buffer.read<std::uint32_t>();
+    }
+
+    out_vertices.resize(buffer.read<std::uint32_t>());
+
+    for(std::size_t i = 0; i < out_vertices.size(); ++i) {
+        qf::throw_if<std::runtime_error>(buffer.is_ended(), "unexpected end-of-file");
+
+        auto& vertex = out_vertices[i];
+
+        vertex.position.x() = buffer.read<float>();
+        vertex.position.y() = buffer.read<float>();
+        vertex.position.z() = buffer.read<float>();
+
+        vertex.normal.x() = buffer.read<float>();
+        vertex.normal.y() = buffer.read<float>();
+        vertex.normal.z() = buffer.read<float>();
+
+        vertex.tangent.x() = buffer.read<float>();
+        vertex.tangent.y() = buffer.read<float>();
+        vertex.tangent.z() = buffer.read<float>();
+        vertex.tangent.w() = buffer.read<float>();
+
+        vertex.texcoord.x() = buffer.read<float>();
+        vertex.texcoord.y() = buffer.read<float>();
+
+        vertex.lightmap.x() = buffer.read<float>();
+        vertex.lightmap.y() = buffer.read<float>();
+    }
+
+    qf::throw_if_not<std::runtime_error>(out_vertices.size() == vertex_count, "vertex lump isn't where it's expected");
+}
+
+void bench::level_load(void)
+{
+    auto vertex_count = bench::option_or("vertices", 2000000);
+    auto runs = bench::option_or("runs", 5);
+    auto flags = cmdline::contains("packed") ? SAVEFLAG_PACKED_VERTICES : 0U;
+
+    qf::throw_if_not<std::invalid_argument>(vertex_count > 0, "option -vertices must be positive");
+
+    LOG_INFO("saving {} vertices to {}", vertex_count, BENCH_LEVEL_PATH);
+
+    // The copying loader only ever knew the float layout
+    save_random_level(vertex_count, 0);
+
+    auto copied_file_mib = level_file_mib();
+
+    std::vector<std::uint32_t> indices;
+    std::vector<LevelVertex> vertices;
+
+    auto copied_ms = bench::best_of(runs, [vertex_count, &indices, &vertices] {
+        load_copied(vertex_count, indices, vertices);
+    });
+
+    indices = std::vector<std::uint32_t>();
+    vertices = std::vector<LevelVertex>();
+
+    auto copied_peak_kib = peak_rss_growth_kib([vertex_count, &indices, &vertices] {
+        load_copied(vertex_count, indices, vertices);
+    });
+
+    indices = std::vector<std::uint32_t>();
+    vertices = std::vector<LevelVertex>();
+
+    if(flags) {
+        save_random_level(vertex_count, flags);
+    }
+
+    auto file_mib = level_file_mib();
+
+    auto load_ms = bench::best_of(runs, [] {
+        Level level;
+        level.load(BENCH_LEVEL_PATH);
+    });
+
+    auto load_peak_kib = peak_rss_growth_kib([] {
+        Level level;
+        level.load(BENCH_LEVEL_PATH);
+    });
+
+    PHYSFS_delete(BENCH_LEVEL_PATH.data());
+
+    LOG_INFO("copying load: {:.1f} MiB in {:.2f} ms, peak RSS +{} KiB", copied_file_mib, copied_ms, copied_peak_kib);
+    LOG_INFO("mapped load{}: {:.1f} MiB in {:.2f} ms, peak RSS +{} KiB", (flags & SAVEFLAG_PACKED_VERTICES) ? ", packed vertices" : "",
+        file_mib, load_ms, load_peak_kib);
+}
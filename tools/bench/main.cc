@@ -0,0 +1,87 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/cmdline.hh"
+#include "core/exceptions.hh"
+#include "core/paths.hh"
+#include "core/utils/physfs.hh"
+
+struct Subcommand final {
+    std::string_view name;
+    std::string_view description;
+    void (*run)(void);
+};
+
+constexpr static Subcommand SUBCOMMANDS[] = {
+    { "bitstream", "bit packing throughput and density per encoding", &bench::bitstream },
+    { "buffer_span", "bulk span reads and writes against per-element ones", &bench::buffer_span },
+    { "job_scaling", "batched traces and leaf lookups from one thread up to all of them", &bench::job_scaling },
+    { "leaf_batch", "batched leaf location for many points and entities against one at a time", &bench::leaf_batch },
+    { "leaf_lookup", "flat tree point location and enumeration against the variant tree walk", &bench::leaf_lookup },
+    { "level_load", "level load time and peak memory against the copying loader it replaced", &bench::level_load },
+    { "portal_flow", "leaves portal flow removes from the PVS and what it costs against is_visible", &bench::portal_flow },
+    { "pvs_bitset", "bitset visibility rows against per-leaf hash sets", &bench::pvs_bitset },
+    { "trace", "line segment traces per second through random trees", &bench::trace },
+};
+
+static void print_usage(const char* argv0)
+{
+    std::cerr << "usage: " << argv0 << " <subcommand> [options]" << std::endl;
+
+    for(const auto& subcommand : SUBCOMMANDS) {
+        std::cerr << "  " << subcommand.name << ": " << subcommand.description << std::endl;
+    }
+}
+
+static void wrapped_main(int argc, char** argv)
+{
+    uulog::add_sink(&uulog::builtin::stderr_ansi);
+
+    if(argc < 2) {
+        print_usage(argv[0]);
+        throw std::invalid_argument("no subcommand given");
+    }
+
+    std::string_view name(argv[1]);
+
+    auto subcommand = std::find_if(std::cbegin(SUBCOMMANDS), std::cend(SUBCOMMANDS), [name](const Subcommand& subcommand) {
+        return subcommand.name == name;
+    });
+
+    if(subcommand == std::cend(SUBCOMMANDS)) {
+        print_usage(argv[0]);
+        throw std::invalid_argument(std::format("unknown subcommand: {}", name));
+    }
+
+    // Options follow the subcommand
+    cmdline::create(argc - 1, argv + 1);
+
+    auto physfs_init_ok = PHYSFS_init(argv[0]);
+    qf::throw_if_not_fmt<std::runtime_error>(physfs_init_ok, "failed to initialize physfs: {}", utils::physfs_error());
+
+    paths::init();
+
+    LOG_INFO("qfortress benchmarks [bench {}]", subcommand->name);
+
+    subcommand->run();
+
+    auto physfs_deinit_ok = PHYSFS_deinit();
+    qf::throw_if_not_fmt<std::runtime_error>(physfs_deinit_ok, "failed to de-initialize physfs: {}", utils::physfs_error());
+}
+
+int main(int argc, char** argv)
+{
+    try {
+        wrapped_main(argc, argv);
+        return EXIT_SUCCESS;
+    }
+    catch(const std::exception& ex) {
+        std::cerr << argv[0] << ": " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch(...) {
+        std::cerr << argv[0] << ": non-std::exception throw" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,11 @@
+#ifndef TOOLS_BENCH_PCH_HH
+#define TOOLS_BENCH_PCH_HH
+#pragma once
+
+#include <core/pch.hh>
+
+#include <charconv>
+#include <fstream>
+#include <numbers>
+
+#endif
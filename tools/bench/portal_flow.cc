@@ -0,0 +1,162 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/bsp/portal_flow.hh"
+#include "core/bsp/pvis.hh"
+#include "core/bsp/pvs.hh"
+#include "core/exceptions.hh"
+#include "core/math/camera.hh"
+#include "core/math/frustum.hh"
+#include "core/utils/bitset.hh"
+
+constexpr static float ROOM_SIZE = 100.0f;
+constexpr static float ROOM_MARGIN = 10.0f;
+constexpr static float DOORWAY_HEIGHT = 30.0f;
+
+/// Grid of square rooms, one leaf each, with every neighbour
+/// connected by a doorway at a random spot of the shared wall
+/// three times out of four; level files carry no portals yet
+static void make_room_grid(std::size_t grid, float doorway, std::mt19937& rng, bsp::PVis& out_pvis)
+{
+    std::uniform_real_distribution<float> offset(ROOM_MARGIN, ROOM_SIZE - ROOM_MARGIN - doorway);
+
+    std::vector<bsp::Portal> portals;
+    std::vector<Eigen::Vector3f> vertices;
+
+    auto add_portal = [&](std::size_t front_leaf, std::size_t back_leaf, const Eigen::Vector3f& corner, const Eigen::Vector3f& along) {
+        bsp::Portal portal;
+        portal.portal_vertex_offset = static_cast<std::uint32_t>(vertices.size());
+        portal.portal_vertex_count = 4;
+        portal.front_leaf_index = static_cast<std::uint32_t>(front_leaf);
+        portal.back_leaf_index = static_cast<std::uint32_t>(back_leaf);
+        portals.push_back(portal);
+
+        Eigen::Vector3f up(0.0f, 0.0f, DOORWAY_HEIGHT);
+        vertices.push_back(corner);
+        vertices.push_back(corner + along);
+        vertices.push_back(corner + along + up);
+        vertices.push_back(corner + up);
+    };
+
+    for(std::size_t y = 0; y < grid; ++y) {
+        for(std::size_t x = 0; x < grid; ++x) {
+            auto leaf = y * grid + x;
+            auto room_x = static_cast<float>(x) * ROOM_SIZE;
+            auto room_y = static_cast<float>(y) * ROOM_SIZE;
+
+            if(x + 1 < grid && rng() % 4) {
+                add_portal(leaf, leaf + 1, Eigen::Vector3f(room_x + ROOM_SIZE, room_y + offset(rng), 0.0f),
+                    Eigen::Vector3f(0.0f, doorway, 0.0f));
+            }
+
+            if(y + 1 < grid && rng() % 4) {
+                add_portal(leaf, leaf + grid, Eigen::Vector3f(room_x + offset(rng), room_y + ROOM_SIZE, 0.0f),
+                    Eigen::Vector3f(doorway, 0.0f, 0.0f));
+            }
+        }
+    }
+
+    out_pvis.set_portals(std::move(portals));
+    out_pvis.set_vertices(std::move(vertices));
+}
+
+void bench::portal_flow(void)
+{
+    auto grid = bench::option_or("grid", 32);
+    auto doorway = static_cast<float>(bench::option_or("doorway", 50));
+    auto viewer_count = bench::option_or("viewers", 64);
+
+    qf::throw_if_not<std::invalid_argument>(grid > 1, "option -grid must be at least 2");
+    qf::throw_if_not<std::invalid_argument>(doorway < ROOM_SIZE - 2.0f * ROOM_MARGIN, "option -doorway doesn't fit the room walls");
+
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> unorm(0.0f, 1.0f);
+
+    bsp::PVis pvis;
+    make_room_grid(grid, doorway, rng, pvis);
+
+    bsp::PortalFlow flow;
+    flow.set_pvis(pvis);
+
+    auto leaf_count = flow.leaf_count();
+    auto row_words = utils::bitset_words(leaf_count);
+
+    // The PVS stand-in for a room is the union of flows
+    // in every direction from a lattice of points inside it
+    std::vector<std::uint64_t> pvs_rows(leaf_count * row_words, UINT64_C(0));
+    std::vector<std::uint64_t> bits;
+
+    for(std::size_t leaf = 0; leaf < leaf_count; ++leaf) {
+        std::span<std::uint64_t> row(pvs_rows.data() + leaf * row_words, row_words);
+        Eigen::Vector3f room(static_cast<float>(leaf % grid) * ROOM_SIZE, static_cast<float>(leaf / grid) * ROOM_SIZE, 0.0f);
+
+        for(int i = 0; i < 5; ++i) {
+            for(int j = 0; j < 5; ++j) {
+                for(int k = 0; k < 3; ++k) {
+                    Eigen::Vector3f point(5.0f + 22.5f * static_cast<float>(i), 5.0f + 22.5f * static_cast<float>(j),
+                        5.0f + 20.0f * static_cast<float>(k));
+                    flow.flow(leaf, room + point, nullptr, bits);
+                    utils::bitset_or(row, bits);
+                }
+            }
+        }
+    }
+
+    bsp::PVS pvs;
+    pvs.set_rows(leaf_count, std::move(pvs_rows));
+
+    math::Camera camera;
+    camera.set_projection_perspective(1.57f, 16.0f / 9.0f, 0.1f, 10000.0f);
+
+    std::size_t pvs_total = 0;
+    std::size_t omni_total = 0;
+    std::size_t frustum_total = 0;
+    double pvs_ms = 0.0;
+    double omni_ms = 0.0;
+    double frustum_ms = 0.0;
+
+    for(std::size_t i = 0; i < viewer_count; ++i) {
+        auto leaf = rng() % leaf_count;
+        Eigen::Vector3f eye(static_cast<float>(leaf % grid) * ROOM_SIZE + ROOM_MARGIN + unorm(rng) * (ROOM_SIZE - 2.0f * ROOM_MARGIN),
+            static_cast<float>(leaf / grid) * ROOM_SIZE + ROOM_MARGIN + unorm(rng) * (ROOM_SIZE - 2.0f * ROOM_MARGIN), 15.0f);
+
+        auto angle = unorm(rng) * 2.0f * std::numbers::pi_v<float>;
+        camera.set_look(eye, eye + Eigen::Vector3f(std::cos(angle), std::sin(angle), 0.0f));
+        camera.update();
+
+        math::Frustum frustum(camera.view_projection());
+
+        // What culling with the PVS alone costs: an
+        // is_visible check for every leaf of the level
+        auto start = std::chrono::steady_clock::now();
+
+        for(std::size_t target = 0; target < leaf_count; ++target) {
+            pvs_total += pvs.is_visible(leaf, target) ? 1 : 0;
+        }
+
+        pvs_ms += bench::elapsed_ms(start);
+
+        start = std::chrono::steady_clock::now();
+        flow.flow(leaf, eye, nullptr, bits);
+        omni_ms += bench::elapsed_ms(start);
+        omni_total += utils::bitset_popcount(bits);
+
+        start = std::chrono::steady_clock::now();
+        flow.flow(leaf, eye, &frustum, bits);
+        frustum_ms += bench::elapsed_ms(start);
+        frustum_total += utils::bitset_popcount(bits);
+    }
+
+    auto viewers = static_cast<double>(viewer_count);
+    auto pvs_average = static_cast<double>(pvs_total) / viewers;
+    auto omni_average = static_cast<double>(omni_total) / viewers;
+    auto frustum_average = static_cast<double>(frustum_total) / viewers;
+
+    LOG_INFO("{}x{} rooms, {} portals, doorways {} units wide, {} viewers", grid, grid, pvis.portals().size(), doorway, viewer_count);
+    LOG_INFO("PVS is_visible: {:.1f} leaves in {:.1f} us", pvs_average, 1000.0 * pvs_ms / viewers);
+    LOG_INFO("flow, all directions: {:.1f} leaves ({:.0f}% removed) in {:.1f} us", omni_average, 100.0 * (1.0 - omni_average / pvs_average),
+        1000.0 * omni_ms / viewers);
+    LOG_INFO("flow, 90 degree view: {:.1f} leaves ({:.0f}% removed) in {:.1f} us", frustum_average,
+        100.0 * (1.0 - frustum_average / pvs_average), 1000.0 * frustum_ms / viewers);
+}
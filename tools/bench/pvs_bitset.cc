@@ -0,0 +1,149 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/bsp/pvs.hh"
+#include "core/exceptions.hh"
+#include "core/utils/bitset.hh"
+
+static std::size_t s_set_bytes = 0;
+
+/// Allocator that counts bytes held by the per-leaf sets
+/// that bsp::PVS stored before it switched to bitsets
+template<typename T>
+struct CountingAllocator final {
+    using value_type = T;
+
+    CountingAllocator(void) = default;
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>&) noexcept
+    {
+        // empty
+    }
+
+    T* allocate(std::size_t count)
+    {
+        s_set_bytes += count * sizeof(T);
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* pointer, std::size_t count) noexcept
+    {
+        s_set_bytes -= count * sizeof(T);
+        std::allocator<T>().deallocate(pointer, count);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+};
+
+using LeafSet = std::unordered_set<std::uint32_t, std::hash<std::uint32_t>, std::equal_to<std::uint32_t>, CountingAllocator<std::uint32_t>>;
+
+void bench::pvs_bitset(void)
+{
+    auto leaf_count = bench::option_or("leaves", 4096);
+    auto visible_percent = bench::option_or("visible", 10);
+    auto query_count = bench::option_or("queries", 4000000);
+    auto runs = bench::option_or("runs", 5);
+
+    qf::throw_if_not<std::invalid_argument>(leaf_count > 0, "option -leaves must be positive");
+
+    std::mt19937 rng(42);
+
+    std::vector<std::unordered_set<std::uint32_t>> visdata(leaf_count);
+    std::vector<LeafSet> set_rows(leaf_count);
+
+    for(std::size_t i = 0; i < leaf_count; ++i) {
+        for(std::uint32_t j = 0; j < leaf_count; ++j) {
+            if(rng() % 100 < visible_percent) {
+                visdata[i].insert(j);
+                set_rows[i].insert(j);
+            }
+        }
+    }
+
+    bsp::PVS pvs;
+    pvs.set_visdata(visdata);
+
+    visdata.clear();
+
+    LOG_INFO("{} leaves, {}% visible, sets -> bitsets", leaf_count, visible_percent);
+    LOG_INFO("memory: {:.2f} MiB -> {:.2f} MiB", static_cast<double>(s_set_bytes) / 1048576.0,
+        static_cast<double>(pvs.rows().size() * sizeof(std::uint64_t)) / 1048576.0);
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> queries(query_count);
+
+    for(auto& query : queries) {
+        query.first = static_cast<std::uint32_t>(rng() % leaf_count);
+        query.second = static_cast<std::uint32_t>(rng() % leaf_count);
+    }
+
+    std::size_t set_visible = 0;
+    std::size_t bitset_visible = 0;
+
+    auto set_query_ms = bench::best_of(runs, [&] {
+        set_visible = 0;
+
+        for(const auto& query : queries) {
+            set_visible += set_rows[query.first].contains(query.second) ? 1 : 0;
+        }
+    });
+
+    auto bitset_query_ms = bench::best_of(runs, [&] {
+        bitset_visible = 0;
+
+        for(const auto& query : queries) {
+            bitset_visible += pvs.is_visible(query.first, query.second) ? 1 : 0;
+        }
+    });
+
+    qf::throw_if_not_fmt<std::runtime_error>(set_visible == bitset_visible, "visible query count mismatch: {} sets, {} bitsets",
+        set_visible, bitset_visible);
+
+    LOG_INFO("{} is_visible: {:.1f} ms -> {:.1f} ms", query_count, set_query_ms, bitset_query_ms);
+
+    std::vector<std::size_t> viewers;
+
+    for(std::size_t i = 0; i < 8; ++i) {
+        viewers.push_back(rng() % leaf_count);
+    }
+
+    std::unordered_set<std::uint32_t> merged_set;
+    std::vector<std::uint64_t> merged_row(pvs.row_words());
+
+    auto set_merge_ms = bench::best_of(runs, [&] {
+        merged_set.clear();
+
+        for(auto viewer : viewers) {
+            merged_set.insert(set_rows[viewer].cbegin(), set_rows[viewer].cend());
+        }
+    });
+
+    auto bitset_merge_ms = bench::best_of(runs, [&] {
+        std::fill(merged_row.begin(), merged_row.end(), UINT64_C(0));
+        pvs.merge_rows(viewers, merged_row);
+    });
+
+    qf::throw_if_not<std::runtime_error>(merged_set.size() == utils::bitset_popcount(merged_row), "merged row mismatch");
+
+    LOG_INFO("merge {} rows: {:.1f} us -> {:.1f} us", viewers.size(), 1000.0 * set_merge_ms, 1000.0 * bitset_merge_ms);
+
+    LeafSet leaves_set;
+    std::vector<std::uint32_t> leaves_vector;
+
+    auto set_leaves_ms = bench::best_of(runs, [&] {
+        leaves_set = set_rows[viewers[0]];
+    });
+
+    auto bitset_leaves_ms = bench::best_of(runs, [&] {
+        pvs.get_visible_leaves(viewers[0], leaves_vector);
+    });
+
+    qf::throw_if_not<std::runtime_error>(leaves_set.size() == leaves_vector.size(), "visible leaves mismatch");
+
+    LOG_INFO("visible leaves of a row: {:.1f} us -> {:.1f} us", 1000.0 * set_leaves_ms, 1000.0 * bitset_leaves_ms);
+}
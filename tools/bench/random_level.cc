@@ -0,0 +1,70 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/random_level.hh"
+
+static std::int32_t make_random_subtree(std::size_t depth, const Eigen::AlignedBox3f& box, std::mt19937& rng,
+    std::vector<Level::Node>& out_nodes)
+{
+    std::uniform_real_distribution<float> tilt(-0.3f, 0.3f);
+
+    if(depth == 0 || (depth < 4 && rng() % 4 == 0)) {
+        if(rng() % 6 == 0) {
+            return -1;
+        }
+
+        out_nodes.emplace_back(Level::Leaf { 0, 0, 0 });
+        return static_cast<std::int32_t>(out_nodes.size() - 1);
+    }
+
+    auto axis = static_cast<int>(depth % 3);
+    Eigen::Vector3f center(box.center());
+    Eigen::Vector3f normal(Eigen::Vector3f::Zero());
+
+    if(rng() % 2) {
+        normal << tilt(rng), tilt(rng), tilt(rng);
+    }
+
+    normal[axis] += 1.0f;
+    normal.normalize();
+
+    auto node_index = static_cast<std::int32_t>(out_nodes.size());
+    out_nodes.emplace_back(Level::Internal { Eigen::Hyperplane<float, 3>(normal, center) });
+
+    Eigen::AlignedBox3f front_box(box);
+    Eigen::AlignedBox3f back_box(box);
+    front_box.min()[axis] = center[axis];
+    back_box.max()[axis] = center[axis];
+
+    auto front = make_random_subtree(depth - 1, front_box, rng, out_nodes);
+    auto back = make_random_subtree(depth - 1, back_box, rng, out_nodes);
+
+    std::get<Level::Internal>(out_nodes[node_index]).front = front;
+    std::get<Level::Internal>(out_nodes[node_index]).back = back;
+
+    return node_index;
+}
+
+std::int32_t bench::make_random_nodes(std::size_t depth, std::uint32_t seed, std::vector<Level::Node>& out_nodes)
+{
+    std::mt19937 rng(seed);
+
+    out_nodes.clear();
+
+    Eigen::AlignedBox3f box(Eigen::Vector3f::Constant(-RANDOM_LEVEL_EXTENT), Eigen::Vector3f::Constant(RANDOM_LEVEL_EXTENT));
+
+    return make_random_subtree(depth, box, rng, out_nodes);
+}
+
+std::vector<Eigen::Vector3f> bench::make_random_points(std::size_t count, std::uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coordinate(-RANDOM_LEVEL_EXTENT, RANDOM_LEVEL_EXTENT);
+
+    std::vector<Eigen::Vector3f> points(count);
+
+    for(auto& point : points) {
+        point = Eigen::Vector3f(coordinate(rng), coordinate(rng), coordinate(rng));
+    }
+
+    return points;
+}
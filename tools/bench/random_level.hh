@@ -0,0 +1,28 @@
+#ifndef TOOLS_BENCH_RANDOM_LEVEL_HH
+#define TOOLS_BENCH_RANDOM_LEVEL_HH
+#pragma once
+
+#include "core/level/level.hh"
+
+namespace bench
+{
+/// Half size of the cube random trees split up
+constexpr static float RANDOM_LEVEL_EXTENT = 1024.0f;
+
+/// Build a random tree that splits a cube along alternating
+/// axes, half of the planes slightly tilted; some subtrees end
+/// early and about every sixth child is solid space
+/// @param depth Depth of the tree, the node count grows as 2^depth
+/// @param seed Random seed
+/// @param out_nodes Nodes in the layout Level::set_nodes takes
+/// @return Root node index or -1 if the whole cube is solid
+std::int32_t make_random_nodes(std::size_t depth, std::uint32_t seed, std::vector<Level::Node>& out_nodes);
+
+/// Random points inside the cube random trees split up
+/// @param count Amount of points
+/// @param seed Random seed
+/// @return Points
+std::vector<Eigen::Vector3f> make_random_points(std::size_t count, std::uint32_t seed);
+} // namespace bench
+
+#endif
@@ -0,0 +1,64 @@
+#include "tools/bench/pch.hh"
+
+#include "tools/bench/bench.hh"
+
+#include "core/exceptions.hh"
+#include "core/level/level.hh"
+
+#include "tools/bench/random_level.hh"
+
+void bench::trace(void)
+{
+    auto ray_count = bench::option_or("rays", 1000000);
+    auto length = static_cast<float>(bench::option_or("length", 300));
+    auto runs = bench::option_or("runs", 3);
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    auto starts = bench::make_random_points(ray_count, 4);
+
+    std::vector<Level::Ray> rays(ray_count);
+
+    for(std::size_t i = 0; i < ray_count; ++i) {
+        Eigen::Vector3f direction(unit(rng), unit(rng), unit(rng));
+        rays[i].start = starts[i];
+        rays[i].end = starts[i] + length * direction.normalized();
+    }
+
+    std::vector<Level::TraceResult> results(ray_count);
+
+    for(std::size_t depth : { 12U, 16U, 20U }) {
+        std::vector<Level::Node> nodes;
+        auto root = bench::make_random_nodes(depth, 1, nodes);
+
+        Level level;
+        level.set_nodes(nodes, root);
+
+        auto single_ms = bench::best_of(runs, [&] {
+            for(std::size_t i = 0; i < ray_count; ++i) {
+                results[i] = level.trace(rays[i].start, rays[i].end);
+            }
+        });
+
+        auto hits = std::count_if(results.cbegin(), results.cend(), [](const Level::TraceResult& result) {
+            return result.fraction < 1.0f;
+        });
+
+        auto batch_ms = bench::best_of(runs, [&] {
+            level.trace_rays(rays, results);
+        });
+
+        auto batch_hits = std::count_if(results.cbegin(), results.cend(), [](const Level::TraceResult& result) {
+            return result.fraction < 1.0f;
+        });
+
+        qf::throw_if_not_fmt<std::runtime_error>(hits == batch_hits, "depth {}: {} hits traced one by one, {} batched", depth, hits,
+            batch_hits);
+
+        auto rays_f = static_cast<double>(ray_count);
+
+        LOG_INFO("{} nodes, {:.0f}% hit: trace {:.2f} Mrays/s, trace_rays {:.2f} Mrays/s", level.nodes().size(),
+            100.0 * static_cast<double>(hits) / rays_f, rays_f / (single_ms * 1000.0), rays_f / (batch_ms * 1000.0));
+    }
+}